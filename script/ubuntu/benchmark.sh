@@ -0,0 +1,337 @@
+#! /bin/bash
+
+set -euo pipefail
+
+BASE_PATH="$(dirname "$0")/../.."
+cd "$BASE_PATH"
+BASE_PATH="$(pwd)"
+
+# Optional git revision to compare against (e.g., "HEAD~1"). It will be built
+# in a temporary worktree.
+BASELINE="${1:-}"
+# The size of the generated workloads (scale with care).
+SIZE="${BENCHMARK_SIZE:-100000}"
+
+WORKSPACE="$(mktemp --directory)"
+trap 'git -C "$BASE_PATH" worktree remove --force "$WORKSPACE/baseline" >/dev/null 2>&1 || true; rm --force --recursive "$WORKSPACE"' EXIT
+
+export LOGGING_LEVEL="ERROR"
+export LOG_IGNORED_LEXEMES="false"
+
+# A routine with a mix of builtins and interpolations, executed many times.
+workload_routine() {
+	awk -v calls="$1" 'BEGIN {
+		print "String name = \"benchmark\";";
+		print "Atomic count = 42;";
+		print "FUN body {";
+		print "\tString a = REV(\"abcdefghijklmnopqrstuvwxyz\");";
+		print "\tString b = TUP(a);";
+		print "\tString c = TLO(b);";
+		print "\tString d = LEN(c);";
+		print "\tString e = RPL(c, \"xyz\", \"XYZ\");";
+		print "\tString f = ECP(e, \"key\");";
+		print "\tString g = \"${name}: ${count} ${d}\";";
+		print "\tOUT(\"${a}-${e}-${g}\");";
+		print "};";
+		for (k = 0; k < calls; ++k) print "body!;";
+	}'
+}
+workload_routine_statements() {
+	echo $((9 * $1 + 3))
+}
+
+# Lots of top-level declarations, each one used right away.
+workload_declarations() {
+	awk -v count="$1" 'BEGIN {
+		for (k = 0; k < count; ++k) {
+			printf "String s%d = REV(\"value %d\");\n", k, k;
+			printf "OUT(\"${s%d}\");\n", k;
+		}
+	}'
+}
+workload_declarations_statements() {
+	echo $((2 * $1))
+}
+
+# A routine that does nothing but output, called many times.
+workload_output() {
+	awk -v calls="$1" 'BEGIN {
+		print "String name = \"world\";";
+		print "FUN body {";
+		print "\tOUT(\"hello ${name}, this is a line\");";
+		print "\tOUT(\"a constant line\");";
+		print "};";
+		for (k = 0; k < calls; ++k) print "body!;";
+	}'
+}
+workload_output_statements() {
+	echo $((3 * $1 + 2))
+}
+
+# Mostly comments, whitespace and literals: it stresses the lexer, while the
+# rest of the pipeline does little work.
+workload_lexer() {
+	awk -v count="$1" 'BEGIN {
+		for (k = 0; k < count; ++k) {
+			printf "/* A comment that the lexer must skip, number %d. */\n", k;
+			printf "\t\t%d   ;   \"a literal string, with some text inside: %d\"   ;\n", k, k;
+		}
+	}'
+}
+workload_lexer_statements() {
+	echo $((2 * $1))
+}
+
+# Interpolations with many fragments, bound to declarations and printed.
+workload_interpolation() {
+	awk -v calls="$1" 'BEGIN {
+		print "String a = \"alpha\";";
+		print "String b = \"beta\";";
+		print "Atomic n = 7;";
+		print "FUN body {";
+		print "\tString s = \"<${a}|${b}|${n}|${a}|${b}|${n}|${a}|${b}|${n}|${a}>\";";
+		print "\tOUT(\"${s} and ${a}, ${b}, ${n} (${s})\");";
+		print "};";
+		for (k = 0; k < calls; ++k) print "body!;";
+	}'
+}
+workload_interpolation_statements() {
+	echo $((3 * $1 + 4))
+}
+
+# Chains of arithmetic over atomic values that are only known at runtime (so
+# they can't be folded), printed and bound to declarations.
+workload_arithmetic() {
+	awk -v calls="$1" 'BEGIN {
+		print "String seed = RND(8, 8, \"ab\");";
+		print "Atomic base = 1000;";
+		print "FUN body {";
+		print "\tOUT(LEN(seed) * base + LEN(seed) - base / LEN(seed) * 3 + 7);";
+		print "\tOUT((LEN(seed) + 1) * (LEN(seed) - 1) * (LEN(seed) + 2) / (LEN(seed) - 3));";
+		print "\tString total = LEN(seed) * LEN(seed) * LEN(seed) * LEN(seed) - base * 2;";
+		print "\tOUT(\"${base}: ${total}\");";
+		print "};";
+		for (k = 0; k < calls; ++k) print "body!;";
+	}'
+}
+workload_arithmetic_statements() {
+	echo $((5 * $1 + 3))
+}
+
+# A long string passed through several variables, and only read, many times.
+workload_aliasing() {
+	awk -v calls="$1" 'BEGIN {
+		print "String text = RND(4096, 4096, \"abcdefgh\");";
+		print "FUN body {";
+		print "\tString a = text;";
+		print "\tString b = a;";
+		print "\tString c = \"${b}\";";
+		print "\tOUT(LEN(a) + LEN(b) + LEN(c));";
+		print "};";
+		for (k = 0; k < calls; ++k) print "body!;";
+	}'
+}
+workload_aliasing_statements() {
+	echo $((4 * $1 + 2))
+}
+
+# A document built up across many declarations, each one appending a piece to
+# the previous one (every version stays alive), and printed at the end.
+workload_concatenation() {
+	awk -v pieces="$1" 'BEGIN {
+		print "String piece = RND(64, 64, \"abcdefgh\");";
+		print "String d0 = piece;";
+		for (k = 1; k <= pieces; ++k) print "String d" k " = d" (k - 1) " + piece;";
+		print "OUT(d" pieces ");";
+	}'
+}
+workload_concatenation_statements() {
+	echo $(($1 + 3))
+}
+
+# Replacements over strings of 64 KB, with pathological inputs for a naive
+# search ("aaa...a", with targets that almost match everywhere), and with
+# results that shrink or grow. The calls are a hundredth of the size.
+workload_replace() {
+	awk -v calls="$(($1 / 100))" 'BEGIN {
+		print "String same = RND(65536, 65536, \"a\");";
+		print "String mixed = RND(65536, 65536, \"ab\");";
+		print "String tail = RND(64, 64, \"a\");";
+		print "FUN body {";
+		print "\tOUT(LEN(RPL(same, \"${tail}b\", \"x\")));";
+		print "\tOUT(LEN(RPL(same, \"aaab\", \"x\")));";
+		print "\tOUT(LEN(RPL(same, \"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab\", \"x\")));";
+		print "\tOUT(LEN(RPL(same, \"${tail}b${tail}\", \"x\")));";
+		print "\tOUT(LEN(RPL(same, \"aa\", \"b\")));";
+		print "\tOUT(LEN(RPL(mixed, \"ab\", \"xyz\")));";
+		print "};";
+		for (k = 0; k < calls; ++k) print "body!;";
+	}'
+}
+workload_replace_statements() {
+	echo $((7 * ($1 / 100) + 4))
+}
+
+# The same rewrite of a string of 64 KB (16 targets: the digits, and some
+# frequent pairs of letters), as a chain of RPL (one pass per target, that
+# also replaces the digits of the previous replacements), or as a single MRP
+# (one pass for all of them). The calls are a hundredth of the size.
+workload_rewrite() {
+	awk -v builtin="$1" -v calls="$(($2 / 100))" 'BEGIN {
+		split("0 1 2 3 4 5 6 7 8 9 th he in er an re", targets, " ");
+		expression = builtin == "RPL" ? "text" : "MRP(text";
+		for (k = 1; k <= 16; ++k) {
+			if (builtin == "RPL") expression = "RPL(" expression ", \"" targets[k] "\", \"<" k ">\")";
+			else expression = expression ", \"" targets[k] "\", \"<" k ">\"";
+		}
+		if (builtin == "MRP") expression = expression ")";
+		print "String text = RND(65536, 65536, \"abcdefghijklmnopqrstuvwxyz0123456789 \");";
+		print "FUN body {";
+		print "\tOUT(LEN(" expression "));";
+		print "};";
+		for (k = 0; k < calls; ++k) print "body!;";
+	}'
+}
+workload_rewrite_statements() {
+	echo $(($2 / 100 + 3))
+}
+
+# Converts the case of a single string of 2^N bytes (built by doubling a piece
+# of 1 KB), 8 times per call, in place. The calls are repeated up to 1 GB of
+# converted bytes (or once, if the string is bigger).
+workload_case() {
+	awk -v exponent="$1" 'BEGIN {
+		print "String s0 = RND(1024, 1024, \"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 \");";
+		for (k = 1; k <= exponent - 10; ++k) print "String s" k " = s" (k - 1) " + s" (k - 1) ";";
+		print "String text = TLO(s" (exponent - 10) ");";
+		print "FUN convert {";
+		print "\tOUT(LEN(TLO(TUP(TLO(TUP(TLO(TUP(TLO(TUP(text))))))))));";
+		print "};";
+		calls = 2 ^ 30 / (8 * 2 ^ exponent);
+		for (k = 0; k < (calls < 1 ? 1 : calls); ++k) print "convert!;";
+	}'
+}
+# The same, with the reversal: the first REV copies the shared string, and the
+# others reverse it in place.
+workload_reverse() {
+	awk -v exponent="$1" 'BEGIN {
+		print "String s0 = RND(1024, 1024, \"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 \");";
+		for (k = 1; k <= exponent - 10; ++k) print "String s" k " = s" (k - 1) " + s" (k - 1) ";";
+		print "String text = REV(s" (exponent - 10) ");";
+		print "FUN convert {";
+		print "\tOUT(LEN(REV(REV(REV(REV(REV(REV(REV(REV(text))))))))));";
+		print "};";
+		calls = 2 ^ 30 / (8 * 2 ^ exponent);
+		for (k = 0; k < (calls < 1 ? 1 : calls); ++k) print "convert!;";
+	}'
+}
+workload_kernel_bytes() {
+	awk -v exponent="$1" 'BEGIN {
+		calls = 2 ^ 30 / (8 * 2 ^ exponent);
+		printf "%.0f", 8 * 2 ^ exponent * (calls < 1 ? 1 : calls);
+	}'
+}
+
+# Runs a compiler over a workload, and prints the elapsed time in seconds.
+measure() {
+	local compiler="$1"
+	local input="$2"
+	local start="$(date +%s%N)"
+	"$compiler" < "$input" > /dev/null
+	local end="$(date +%s%N)"
+	awk -v start="$start" -v end="$end" 'BEGIN { printf "%.3f", (end - start) / 1e9 }'
+}
+
+# Runs a compiler over a workload, and prints the seconds until the first byte
+# of its output.
+measure_first_byte() {
+	local compiler="$1"
+	local input="$2"
+	local start="$(date +%s%N)"
+	local first="$("$compiler" < "$input" | { head --bytes=1 > /dev/null; date +%s%N; cat > /dev/null; })"
+	awk -v start="$start" -v first="$first" 'BEGIN { printf "%.3f", (first - start) / 1e9 }'
+}
+
+# Runs a compiler over a workload, and prints its peak resident memory in KB
+# (only if GNU time is installed).
+measure_peak_memory() {
+	local compiler="$1"
+	local input="$2"
+	if [ -x /usr/bin/time ]; then
+		/usr/bin/time --format=%M "$compiler" < "$input" 2>&1 > /dev/null | tail --lines=1
+	else
+		echo "?"
+	fi
+}
+
+report() {
+	local name="$1"
+	local compiler="$2"
+	local input="$3"
+	local statements="$4"
+	local seconds="$(measure "$compiler" "$input")"
+	local size="$(stat --format=%s "$input")"
+	awk -v name="$name" -v seconds="$seconds" -v statements="$statements" -v size="$size" 'BEGIN {
+		printf "    %-40s %8.3f s %14.0f statements/s %10.2f MB/s\n", name, seconds, statements / seconds, size / seconds / 1048576
+	}'
+}
+
+COMPILERS=("current:$BASE_PATH/build/Compiler")
+
+if [ -n "$BASELINE" ]; then
+	echo "Building baseline \"$BASELINE\"..."
+	git worktree add --detach "$WORKSPACE/baseline" "$BASELINE" >/dev/null
+	cmake -S "$WORKSPACE/baseline" -B "$WORKSPACE/baseline/build" >/dev/null
+	cmake --build "$WORKSPACE/baseline/build" >/dev/null
+	COMPILERS+=("baseline:$WORKSPACE/baseline/build/Compiler")
+fi
+
+for workload in routine declarations lexer output interpolation arithmetic aliasing concatenation replace; do
+	input="$WORKSPACE/$workload.concat"
+	"workload_$workload" "$SIZE" > "$input"
+	statements="$("workload_${workload}_statements" "$SIZE")"
+	echo "Workload \"$workload\" ($statements statements)..."
+	for entry in "${COMPILERS[@]}"; do
+		report "${entry%%:*}" "${entry#*:}" "$input" "$statements"
+	done
+done
+
+# The streaming mode runs every statement as soon as it's parsed: compare
+# when the output starts, and how much memory it takes.
+for workload in declarations routine; do
+	input="$WORKSPACE/$workload.concat"
+	echo "Workload \"$workload\" (time to first byte, and peak memory)..."
+	for mode in BATCH STREAMING; do
+		first="$(EXECUTION_MODE="$mode" measure_first_byte "$BASE_PATH/build/Compiler" "$input")"
+		memory="$(EXECUTION_MODE="$mode" measure_peak_memory "$BASE_PATH/build/Compiler" "$input")"
+		printf "    %-40s %8.3f s %10s KB\n" "$mode" "$first" "$memory"
+	done
+done
+
+# Many replacements at once, with the current compiler only (MRP is new).
+input="$WORKSPACE/rewrite.concat"
+echo "Workload \"rewrite\" ($(workload_rewrite_statements RPL "$SIZE") statements)..."
+for builtin in RPL MRP; do
+	"workload_rewrite" "$builtin" "$SIZE" > "$input"
+	report "current ($builtin)" "$BASE_PATH/build/Compiler" "$input" "$(workload_rewrite_statements "$builtin" "$SIZE")"
+done
+
+# The case conversion (TUP and TLO) and the reversal (REV) with every
+# instruction set, from 1 KB to 1 GB (the unsupported ones fall back to the
+# best available).
+for workload in case reverse; do
+	for exponent in ${BENCHMARK_CASE_EXPONENTS:-10 15 20 25 30}; do
+		input="$WORKSPACE/$workload-$exponent.concat"
+		"workload_$workload" "$exponent" > "$input"
+		bytes="$(workload_kernel_bytes "$exponent")"
+		echo "Workload \"$workload\" (2^$exponent bytes per string, $bytes bytes converted)..."
+		for instructionSet in SCALAR SSE2 AVX2 AVX512; do
+			seconds="$(INSTRUCTION_SET="$instructionSet" measure "$BASE_PATH/build/Compiler" "$input")"
+			awk -v name="current ($instructionSet)" -v seconds="$seconds" -v bytes="$bytes" 'BEGIN {
+				printf "    %-40s %8.3f s %10.2f MB/s\n", name, seconds, bytes / seconds / 1048576
+			}'
+		done
+	done
+done
+
+echo "All done."
@@ -13,10 +13,23 @@ STATUS=0
 echo "Compiler should accept..."
 echo ""
 
+# An accepted test can run under the variables of "src/test/c/environment/$test"
+# (one "NAME=value" per line), and if "src/test/c/output/$test" exists, its
+# output must be exactly that one.
+OUTPUT="$(mktemp)"
+trap 'rm -f "$OUTPUT"' EXIT
+
 for test in $(ls src/test/c/accept/); do
-	cat "src/test/c/accept/$test" | build/Compiler >/dev/null 2>&1
+	ENVIRONMENT=""
+	if [ -f "src/test/c/environment/$test" ]; then
+		ENVIRONMENT="$(cat "src/test/c/environment/$test")"
+	fi
+	cat "src/test/c/accept/$test" | env $ENVIRONMENT build/Compiler >"$OUTPUT" 2>/dev/null
 	RESULT="$?"
-	if [ "$RESULT" == "0" ]; then
+	if [ "$RESULT" == "0" ] && [ -f "src/test/c/output/$test" ] && ! cmp -s "$OUTPUT" "src/test/c/output/$test"; then
+		STATUS=1
+		echo -e "    $test, ${RED}but its output differs${OFF} (status $RESULT)"
+	elif [ "$RESULT" == "0" ]; then
 		echo -e "    $test, ${GREEN}and it does${OFF} (status $RESULT)"
 	else
 		STATUS=1
@@ -7,11 +7,28 @@
 @echo Compiler should accept...
 @echo:
 
+@rem An accepted test can run under the variables of "src\test\c\environment\<test>"
+@rem (one "NAME=value" per line), and if "src\test\c\output\<test>" exists, its
+@rem output must be exactly that one.
+@set OUTPUT=%TEMP%\compiler-test-output
+
 @set STATUS=0
 @for /f %%f in ('dir /b !BASE_PATH!\src\test\c\accept') do @(
-	@type !BASE_PATH!\src\test\c\accept\%%f | !BASE_PATH!\build\Debug\Compiler.exe >nul 2>&1
+	@set ENVIRONMENT=!BASE_PATH!\src\test\c\environment\%%f
+	@set EXPECTED=!BASE_PATH!\src\test\c\output\%%f
+	@if exist "!ENVIRONMENT!" for /f "usebackq delims=" %%v in ("!ENVIRONMENT!") do @set "%%v"
+	@type !BASE_PATH!\src\test\c\accept\%%f | !BASE_PATH!\build\Debug\Compiler.exe >"!OUTPUT!" 2>nul
 	@set RESULT=!ERRORLEVEL!
-	if !RESULT! equ 0 (
+	@if exist "!ENVIRONMENT!" for /f "usebackq tokens=1 delims==" %%v in ("!ENVIRONMENT!") do @set "%%v="
+	@set DIFFERS=0
+	@if !RESULT! equ 0 if exist "!EXPECTED!" (
+		@fc /b "!OUTPUT!" "!EXPECTED!" >nul 2>&1
+		@if !ERRORLEVEL! neq 0 @set DIFFERS=1
+	)
+	if !DIFFERS! equ 1 (
+		@set STATUS=1
+		@echo     "%%f", [91mbut its output differs[0m ^(status !RESULT!^)
+	) else if !RESULT! equ 0 (
 		@echo     "%%f", [92mand it does[0m ^(status !RESULT!^)
 	) else (
 		@set STATUS=1
@@ -34,6 +51,7 @@
 	)
 )
 
+@del "%OUTPUT%" >nul 2>&1
 @exit /B %STATUS%
 
 @ENDLOCAL
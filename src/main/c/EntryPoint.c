@@ -1,6 +1,8 @@
 #include "backend/code-generation/Generator.h"
+#include "backend/optimization/ConstantFolding.h"
 #include "backend/semantic-analysis/SemanticAnalyzer.h"
 #include "frontend/lexical-analysis/FlexActions.h"
+#include "frontend/lexical-analysis/SourceInput.h"
 #include "frontend/syntactic-analysis/AbstractSyntaxTree.h"
 #include "frontend/syntactic-analysis/BisonActions.h"
 #include "frontend/syntactic-analysis/SyntacticAnalyzer.h"
@@ -9,65 +11,169 @@
 #include "shared/Logger.h"
 #include "shared/String.h"
 
+/**
+ * The state of a streamed compilation, between its statements.
+ */
+typedef struct {
+	SymbolTable * symbolTable;
+	ConstantFolder * constantFolder;
+	StreamGenerator * generator;
+} Stream;
+
+/**
+ * Analyzes and runs a top-level statement of a streamed program, as soon as
+ * it's parsed.
+ */
+static boolean _streamStatement(CompilerState * compilerState, Statement * statement, void * context) {
+	Stream * stream = context;
+	return performStatementAnalysis(statement, compilerState->expressions, stream->symbolTable)
+		&& foldStatement(stream->constantFolder, statement)
+		&& generateStatement(stream->generator, statement);
+}
 
 /**
  * The main entry-point of the entire application. If you use "strtok" to
  * parse anything inside this project instead of using Flex and Bison, I will
  * find you, and I will kill you (Bryan Mills; "Taken", 2008).
+ *
+ * The program to compile is read from the path of the first argument, or from
+ * the standard input if there is none. In the streaming mode (see the
+ * "EXECUTION_MODE" environment variable), every statement runs as soon as
+ * it's parsed, so the output starts before the whole program is read (a
+ * pipe or a terminal is read as it arrives).
  */
 const int main(const int count, const char ** arguments) {
+	initializeLoggerModule();
 	Logger * logger = createLogger("EntryPoint");
 
-	initializeFlexActionsModule();
-	initializeBisonActionsModule();
-	initializeSyntacticAnalyzerModule();
-	initializeAbstractSyntaxTreeModule();
-
 	// Logs the arguments of the application.
 	for (int k = 0; k < count; ++k) {
 		logDebugging(logger, "Argument %d: \"%s\"", k, arguments[k]);
 	}
 
+	const boolean streaming = strcmp(getStringOrDefault("EXECUTION_MODE", "BATCH"), "STREAMING") == 0;
+	initializeSourceInputModule();
+	SourceInput * sourceInput = openSourceInput(count < 2 ? NULL : arguments[1], streaming);
+	if (sourceInput == NULL) {
+		shutdownSourceInputModule();
+		destroyLogger(logger);
+		shutdownLoggerModule();
+		return FAILED;
+	}
+
+	initializeFlexActionsModule();
+	initializeBisonActionsModule();
+	initializeSyntacticAnalyzerModule();
+	initializeAbstractSyntaxTreeModule();
+	initializeSymbolTableModule();
+	initializeSemanticAnalyzerModule();
+	initializeConstantFoldingModule();
+	initializeGeneratorModule();
+
 	// Begin compilation process.
 	CompilerState compilerState = {
 		.abstractSyntaxtTree = NULL,
+		.arena = createArena(),
+		.expressions = createExpressionPool(),
+		.interner = createInterner(),
+		.output = stdout,
+		.streaming = false,
+		.streamedStatement = NULL,
 		.succeed = false,
 		.value = 0
 	};
-	const SyntacticAnalysisStatus syntacticAnalysisStatus = parse(&compilerState);			// FRONT
+	SyntacticAnalysisStatus syntacticAnalysisStatus;
 	CompilationStatus compilationStatus = SUCCEED;
-	Program * program = compilerState.abstractSyntaxtTree;
-
-	if (syntacticAnalysisStatus == ACCEPT) {												// BACK
-		
-		logDebugging(logger, "Parsing succeeded. Starting semantic analysis...");
+	SymbolTable * table = createSymbolTable();
 
-		SymbolTable* table = createSymbolTable();
+	if (compilerState.arena == NULL || compilerState.expressions == NULL || compilerState.interner == NULL || table == NULL) {
+		logError(logger, "Cannot allocate the state of the compilation.");
+		syntacticAnalysisStatus = OUT_OF_MEMORY;
+		compilationStatus = FAILED;
+	}
+	else if (streaming) {
+		logDebugging(logger, "Parsing, analyzing and generating statement by statement...");
 
-		if (performSemanticAnalysis(program, table)) {
-			logDebugging(logger, "Semantic analysis succeeded. Starting code generation...");
+		Stream stream = {
+			.symbolTable = table,
+			.constantFolder = createConstantFolder(&compilerState, table),
+			.generator = createStreamGenerator(&compilerState, table)
+		};
+		syntacticAnalysisStatus = stream.constantFolder == NULL || stream.generator == NULL
+			? OUT_OF_MEMORY
+			: parseStreaming(&compilerState, sourceInput, _streamStatement, &stream);	// FRONT & BACK
+		destroyStreamGenerator(stream.generator);
+		destroyConstantFolder(stream.constantFolder);
 
-			generate(&compilerState, table);
+		if (syntacticAnalysisStatus == ABORTED) {
+			logError(logger, "The execution of the streamed program failed.");
+			syntacticAnalysisStatus = ACCEPT;
+			compilationStatus = FAILED;
 		}
-		else {
-			logError(logger, "Semantic analysis failed.");
+		else if (syntacticAnalysisStatus != ACCEPT) {
+			logError(logger, "The syntactic-analysis phase rejects the input program.");
 			compilationStatus = FAILED;
 		}
 	}
 	else {
-		logError(logger, "The syntactic-analysis phase rejects the input program.");
-		compilationStatus = FAILED;
+		syntacticAnalysisStatus = parse(&compilerState, sourceInput);						// FRONT
+		Program * program = compilerState.abstractSyntaxtTree;
+
+		if (syntacticAnalysisStatus == ACCEPT) {											// BACK
+			
+			logDebugging(logger, "Parsing succeeded. Starting semantic analysis...");
+
+			if (performSemanticAnalysis(program, table)) {
+				logDebugging(logger, "Semantic analysis succeeded. Starting code generation...");
+
+				if (!foldConstants(&compilerState, table)) {
+					logError(logger, "Constant folding failed.");
+					compilationStatus = FAILED;
+				}
+				else if (!generate(&compilerState, table)) {
+					logError(logger, "Code generation failed.");
+					compilationStatus = FAILED;
+				}
+			}
+			else {
+				logError(logger, "Semantic analysis failed.");
+				compilationStatus = FAILED;
+			}
+		}
+		else {
+			logError(logger, "The syntactic-analysis phase rejects the input program.");
+			compilationStatus = FAILED;
+		}
 	}
 
-	logDebugging(logger, "Releasing AST resources...");
-	releaseProgram(program);
+	destroySymbolTable(table);
+	if (compilerState.arena != NULL && compilerState.expressions != NULL) {
+		logDebugging(logger, "Releasing AST resources (%zu bytes, and %u expressions of %zu bytes each)...",
+			compilerState.arena->allocated, compilerState.expressions->count, sizeof(Expression));
+	}
+	destroyArena(compilerState.arena);
+	destroyExpressionPool(compilerState.expressions);
+	if (compilerState.interner != NULL) {
+		const InternerStatistics internerStatistics = getInternerStatistics(compilerState.interner);
+		logDebugging(logger, "Releasing %zu interned strings (%zu bytes, out of %zu requested strings with %zu bytes)...",
+			internerStatistics.strings, internerStatistics.storedBytes,
+			internerStatistics.requests, internerStatistics.requestedBytes);
+	}
+	destroyInterner(compilerState.interner);
+	closeSourceInput(sourceInput);
 	logDebugging(logger, "Releasing modules resources...");
+	shutdownGeneratorModule();
+	shutdownConstantFoldingModule();
+	shutdownSemanticAnalyzerModule();
+	shutdownSymbolTableModule();
 	shutdownAbstractSyntaxTreeModule();
 	shutdownSyntacticAnalyzerModule();
 	shutdownBisonActionsModule();
 	shutdownFlexActionsModule();
+	shutdownSourceInputModule();
 	logDebugging(logger, "Compilation is done.");
 	destroyLogger(logger);
+	shutdownLoggerModule();
 
-	return syntacticAnalysisStatus;
+	return syntacticAnalysisStatus == ACCEPT ? compilationStatus : syntacticAnalysisStatus;
 }
\ No newline at end of file
@@ -0,0 +1,264 @@
+#include "Automaton.h"
+
+#define ROOT_STATE					0
+#define NO_STATE					UINT32_MAX
+
+/** PRIVATE FUNCTIONS */
+
+static uint32_t _child(const Automaton * automaton, const uint32_t state, const unsigned char byte);
+static uint32_t _next(const Automaton * automaton, uint32_t state, const unsigned char byte);
+static void _choosePrefilter(Automaton * automaton);
+static size_t _skip(const Automaton * automaton, const char * haystack, const size_t from, const size_t length);
+static boolean _buildTransitions(Automaton * automaton, const uint32_t * order);
+static inline size_t _scanTable(const Automaton * automaton, const char * haystack, const size_t length, const size_t from, unsigned int * target, const boolean prefiltered);
+
+/**
+ * The child of a state in the trie, through a byte (or NO_STATE).
+ */
+static uint32_t _child(const Automaton * automaton, const uint32_t state, const unsigned char byte) {
+	if (state == ROOT_STATE) {
+		return automaton->root[byte] == ROOT_STATE ? NO_STATE : automaton->root[byte];
+	}
+	uint32_t child = automaton->children[state];
+	while (child != NO_STATE && automaton->bytes[child] != byte) {
+		child = automaton->siblings[child];
+	}
+	return child;
+}
+
+/**
+ * The transition of a state through a byte, following the failure links
+ * until a state has a child through it (or until the root).
+ */
+static uint32_t _next(const Automaton * automaton, uint32_t state, const unsigned char byte) {
+	while (state != ROOT_STATE) {
+		const uint32_t child = _child(automaton, state, byte);
+		if (child != NO_STATE) {
+			return child;
+		}
+		state = automaton->failures[state];
+	}
+	return automaton->root[byte];
+}
+
+/**
+ * The prefilter looks for the first bytes of the targets (the ones that
+ * leave the root), repeated to fill the 3 of the kernel.
+ */
+static void _choosePrefilter(Automaton * automaton) {
+	unsigned int count = 0;
+	for (unsigned int byte = 0; byte < 256; ++byte) {
+		if (automaton->root[byte] != ROOT_STATE) {
+			if (count == MAXIMUM_START_BYTES) {
+				return;
+			}
+			automaton->startBytes[count++] = (char) byte;
+		}
+	}
+	for (unsigned int k = count; 0 < count && k < MAXIMUM_START_BYTES; ++k) {
+		automaton->startBytes[k] = automaton->startBytes[0];
+	}
+	automaton->prefiltered = 0 < count;
+}
+
+/**
+ * The next index where a target can start (or the length).
+ */
+static size_t _skip(const Automaton * automaton, const char * haystack, const size_t from, const size_t length) {
+	const char * bytes = automaton->startBytes;
+	return findAny(haystack, from, length, bytes[0], bytes[1], bytes[2]);
+}
+
+/**
+ * Every missing transition is the one of the failure link, which is
+ * shallower, so it's already known when the states are built in breadth-first
+ * order.
+ */
+static boolean _buildTransitions(Automaton * automaton, const uint32_t * order) {
+	const unsigned int count = automaton->stateCount;
+	uint32_t * rows = malloc(count * sizeof(uint32_t));
+	automaton->transitions = malloc((size_t) count * 256 * sizeof(uint32_t));
+	automaton->rowTargets = malloc(count * sizeof(uint32_t));
+	if (rows == NULL || automaton->transitions == NULL || automaton->rowTargets == NULL) {
+		free(rows);
+		return false;
+	}
+
+	// The root has no target, so it keeps the first row.
+	uint32_t next = 0;
+	uint32_t last = count;
+	for (unsigned int k = 0; k < count; ++k) {
+		const uint32_t state = order[k];
+		const uint32_t row = automaton->targets[state] == NO_TARGET ? next++ : --last;
+		rows[state] = 256 * row;
+		automaton->rowTargets[row] = automaton->targets[state];
+	}
+	automaton->firstTargetRow = 256 * next;
+
+	for (unsigned int byte = 0; byte < 256; ++byte) {
+		automaton->transitions[byte] = rows[automaton->root[byte]];
+	}
+	for (unsigned int k = 1; k < count; ++k) {
+		const uint32_t state = order[k];
+		uint32_t * transitions = automaton->transitions + rows[state];
+		memcpy(transitions, automaton->transitions + rows[automaton->failures[state]], 256 * sizeof(uint32_t));
+		for (uint32_t child = automaton->children[state]; child != NO_STATE; child = automaton->siblings[child]) {
+			transitions[automaton->bytes[child]] = rows[child];
+		}
+	}
+	free(rows);
+	return true;
+}
+
+/**
+ * The scan of "findTarget" with the complete transitions. It's inlined with
+ * a constant prefilter flag, so the loop without it has no extra check.
+ */
+static inline size_t _scanTable(const Automaton * automaton, const char * haystack, const size_t length, const size_t from, unsigned int * target, const boolean prefiltered) {
+	const unsigned char * bytes = (const unsigned char *) haystack;
+	const uint32_t * transitions = automaton->transitions;
+	const uint32_t firstTargetRow = automaton->firstTargetRow;
+	uint32_t row = 0;
+	for (size_t k = from; k < length; ++k) {
+		if (prefiltered && row == 0 && transitions[bytes[k]] == 0) {
+			if ((k = _skip(automaton, haystack, k, length)) == length) { break; }
+		}
+		row = transitions[row + bytes[k]];
+		if (firstTargetRow <= row) {
+			*target = automaton->rowTargets[row / 256];
+			return k + 1 - automaton->lengths[*target];
+		}
+	}
+	return NOT_FOUND;
+}
+
+/** PUBLIC FUNCTIONS */
+
+Automaton * createAutomaton(const char * const * targets, const size_t * lengths, const unsigned int count) {
+	size_t capacity = 1;
+	for (unsigned int k = 0; k < count; ++k) {
+		capacity += lengths[k];
+		if (NO_STATE <= capacity) {
+			return NULL;
+		}
+	}
+	Automaton * automaton = calloc(1, sizeof(Automaton));
+	if (automaton == NULL) {
+		return NULL;
+	}
+	automaton->children = malloc(capacity * sizeof(uint32_t));
+	automaton->siblings = malloc(capacity * sizeof(uint32_t));
+	automaton->bytes = malloc(capacity);
+	automaton->failures = malloc(capacity * sizeof(uint32_t));
+	automaton->targets = malloc(capacity * sizeof(uint32_t));
+	automaton->lengths = malloc((count == 0 ? 1 : count) * sizeof(size_t));
+	uint32_t * order = malloc(capacity * sizeof(uint32_t));
+	if (automaton->children == NULL || automaton->siblings == NULL || automaton->bytes == NULL
+		|| automaton->failures == NULL || automaton->targets == NULL || automaton->lengths == NULL || order == NULL) {
+		free(order);
+		destroyAutomaton(automaton);
+		return NULL;
+	}
+
+	// The trie (the root has no children list, but its complete transitions).
+	automaton->stateCount = 1;
+	automaton->children[ROOT_STATE] = NO_STATE;
+	automaton->failures[ROOT_STATE] = ROOT_STATE;
+	automaton->targets[ROOT_STATE] = NO_TARGET;
+	automaton->targetCount = count;
+	for (unsigned int k = 0; k < count; ++k) {
+		automaton->lengths[k] = lengths[k];
+		uint32_t state = ROOT_STATE;
+		for (size_t j = 0; j < lengths[k]; ++j) {
+			const unsigned char byte = targets[k][j];
+			uint32_t child = _child(automaton, state, byte);
+			if (child == NO_STATE) {
+				child = automaton->stateCount++;
+				automaton->bytes[child] = byte;
+				automaton->children[child] = NO_STATE;
+				automaton->targets[child] = NO_TARGET;
+				if (state == ROOT_STATE) {
+					automaton->root[byte] = child;
+				}
+				else {
+					automaton->siblings[child] = automaton->children[state];
+					automaton->children[state] = child;
+				}
+			}
+			state = child;
+		}
+		if (state != ROOT_STATE && automaton->targets[state] == NO_TARGET) {
+			automaton->targets[state] = k;
+		}
+	}
+
+	_choosePrefilter(automaton);
+
+	// The failure links, in breadth-first order. A state where no target
+	// ends inherits the longest one of its failure link.
+	unsigned int tail = 0;
+	order[tail++] = ROOT_STATE;
+	for (unsigned int byte = 0; byte < 256; ++byte) {
+		const uint32_t child = automaton->root[byte];
+		if (child != ROOT_STATE) {
+			automaton->failures[child] = ROOT_STATE;
+			order[tail++] = child;
+		}
+	}
+	for (unsigned int head = 1; head < tail; ++head) {
+		const uint32_t state = order[head];
+		for (uint32_t child = automaton->children[state]; child != NO_STATE; child = automaton->siblings[child]) {
+			const uint32_t failure = _next(automaton, automaton->failures[state], automaton->bytes[child]);
+			automaton->failures[child] = failure;
+			if (automaton->targets[child] == NO_TARGET) {
+				automaton->targets[child] = automaton->targets[failure];
+			}
+			order[tail++] = child;
+		}
+	}
+
+	const boolean succeed = MAXIMUM_TABLE_STATES < automaton->stateCount || _buildTransitions(automaton, order);
+	free(order);
+	if (!succeed) {
+		destroyAutomaton(automaton);
+		return NULL;
+	}
+	return automaton;
+}
+
+void destroyAutomaton(Automaton * automaton) {
+	if (automaton == NULL) { return; }
+
+	free(automaton->children);
+	free(automaton->siblings);
+	free(automaton->bytes);
+	free(automaton->failures);
+	free(automaton->targets);
+	free(automaton->transitions);
+	free(automaton->rowTargets);
+	free(automaton->lengths);
+	free(automaton);
+}
+
+size_t findTarget(const Automaton * automaton, const char * haystack, const size_t length, const size_t from, unsigned int * target) {
+	const unsigned char * bytes = (const unsigned char *) haystack;
+	const boolean prefiltered = automaton->prefiltered;
+	if (automaton->transitions != NULL) {
+		return prefiltered
+			? _scanTable(automaton, haystack, length, from, target, true)
+			: _scanTable(automaton, haystack, length, from, target, false);
+	}
+
+	uint32_t state = ROOT_STATE;
+	for (size_t k = from; k < length; ++k) {
+		if (prefiltered && state == ROOT_STATE && automaton->root[bytes[k]] == ROOT_STATE) {
+			if ((k = _skip(automaton, haystack, k, length)) == length) { break; }
+		}
+		state = _next(automaton, state, bytes[k]);
+		if (automaton->targets[state] != NO_TARGET) {
+			*target = automaton->targets[state];
+			return k + 1 - automaton->lengths[*target];
+		}
+	}
+	return NOT_FOUND;
+}
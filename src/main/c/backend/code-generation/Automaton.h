@@ -0,0 +1,85 @@
+#ifndef AUTOMATON_HEADER
+#define AUTOMATON_HEADER
+
+#include "../../shared/Type.h"
+#include "Finder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The most states that get a complete transition table (256 transitions of
+ * 4 bytes each, so 1 MB at most). The bigger automata follow the failure
+ * links instead, which takes less memory, but it's slower.
+ */
+#define MAXIMUM_TABLE_STATES		1024
+
+/** The most first bytes of the targets that the prefilter can look for. */
+#define MAXIMUM_START_BYTES			3
+
+/**
+ * An Aho-Corasick automaton, that finds many targets in a single pass: a
+ * trie of the targets, where every state also knows its longest suffix in
+ * the trie (its failure link), and the longest target that ends in it. The
+ * targets are copied into the trie, so they don't need to outlive it. If they
+ * start with 3 bytes at most, the scan skips from the root to the next of
+ * them with a vectorized prefilter (see "findAny"), instead of a byte at a
+ * time.
+ *
+ * @see https://doi.org/10.1145/360825.360855
+ */
+typedef struct {
+	// The trie: the first child and the next sibling of every state, and
+	// the byte of the transition into it. The root is the state zero, and
+	// its transitions are complete.
+	uint32_t * children;
+	uint32_t * siblings;
+	unsigned char * bytes;
+	uint32_t root[256];
+	char startBytes[MAXIMUM_START_BYTES];
+	boolean prefiltered;
+
+	// The failure link of every state, and the longest target that ends in
+	// it (or NO_TARGET).
+	uint32_t * failures;
+	uint32_t * targets;
+	unsigned int stateCount;
+
+	// The complete transitions of every state (or NULL if there are too many
+	// states, see MAXIMUM_TABLE_STATES). The states of the table are
+	// renumbered, so the ones where a target ends come last, and every
+	// transition is the offset of the row of its state. So the scan needs a
+	// single load and a comparison per byte.
+	uint32_t * transitions;
+	uint32_t * rowTargets;
+	uint32_t firstTargetRow;
+
+	size_t * lengths;
+	unsigned int targetCount;
+} Automaton;
+
+/** The target of a state where none ends. */
+#define NO_TARGET					UINT32_MAX
+
+/**
+ * Builds the automaton of some targets. The empty ones are never found, and
+ * if a target is repeated, its first occurrence is the one found. Returns
+ * NULL if the system runs out of memory.
+ */
+Automaton * createAutomaton(const char * const * targets, const size_t * lengths, const unsigned int count);
+
+/**
+ * Destroy an automaton.
+ */
+void destroyAutomaton(Automaton * automaton);
+
+/**
+ * The start of the first target that ends in a haystack from another index
+ * (the longest one, if many end at the same index), or NOT_FOUND. The index
+ * of the target is left in "target". Searching again from its end scans
+ * every byte once.
+ */
+size_t findTarget(const Automaton * automaton, const char * haystack, const size_t length, const size_t from, unsigned int * target);
+
+#endif
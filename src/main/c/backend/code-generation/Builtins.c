@@ -0,0 +1,374 @@
+#include "Builtins.h"
+
+/**
+ * GCC and Clang detect the overflow of an operation from the flags of the
+ * processor. Other compilers fall back to check the operands.
+ *
+ * @see https://gcc.gnu.org/onlinedocs/gcc/Integer-Overflow-Builtins.html
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define OVERFLOW_BUILTINS
+#endif
+
+/* MODULE INTERNAL STATE */
+
+static Logger * _logger = NULL;
+static boolean _reverseCodePoints = false;
+
+/* PUBLIC FUNCTIONS */
+
+void initializeBuiltinsModule() {
+	_logger = createLogger("Builtins");
+	_reverseCodePoints = strcmp(getStringOrDefault("REVERSE_MODE", "BYTES"), "UTF8") == 0;
+	logDebugging(_logger, "REV reverses the %s.", _reverseCodePoints ? "code points" : "bytes");
+}
+
+void shutdownBuiltinsModule() {
+	if (_logger != NULL) {
+		destroyLogger(_logger);
+	}
+}
+
+
+size_t formatAtomic(const int64_t value, char * buffer) {
+	char digits[ATOMIC_BUFFER_SIZE];
+	char * digit = digits + sizeof(digits);
+	uint64_t magnitude = value < 0 ? -(uint64_t) value : (uint64_t) value;
+
+	do {
+		*--digit = '0' + (magnitude % 10);
+		magnitude /= 10;
+	} while (0 < magnitude);
+	if (value < 0) {
+		*--digit = '-';
+	}
+
+	const size_t length = digits + sizeof(digits) - digit;
+	memcpy(buffer, digit, length);
+	return length;
+}
+
+int64_t parseAtomic(const char * string) {
+	return strtoll(string, NULL, 10);
+}
+
+boolean builtinArithmetic(const ArithmeticOperator operator, const int64_t left, const int64_t right, int64_t * result) {
+	switch (operator) {
+		case ADDITION:
+#ifdef OVERFLOW_BUILTINS
+			return !__builtin_add_overflow(left, right, result);
+#else
+			if (0 < right ? INT64_MAX - right < left : left < INT64_MIN - right) { return false; }
+			*result = left + right;
+			return true;
+#endif
+		case SUBTRACTION:
+#ifdef OVERFLOW_BUILTINS
+			return !__builtin_sub_overflow(left, right, result);
+#else
+			if (0 < right ? left < INT64_MIN + right : INT64_MAX + right < left) { return false; }
+			*result = left - right;
+			return true;
+#endif
+		case MULTIPLICATION:
+#ifdef OVERFLOW_BUILTINS
+			return !__builtin_mul_overflow(left, right, result);
+#else
+			if (left != 0 && right != 0 && (0 < left
+					? (0 < right ? INT64_MAX / right < left : right < INT64_MIN / left)
+					: (0 < right ? left < INT64_MIN / right : left < INT64_MAX / right))) {
+				return false;
+			}
+			*result = left * right;
+			return true;
+#endif
+		case DIVISION:
+			if (right == 0 || (left == INT64_MIN && right == -1)) { return false; }
+			*result = left / right;
+			return true;
+		default:
+			return false;
+	}
+}
+
+/**
+ * The builtins need contiguous characters, so their arguments are flattened
+ * first (but LEN, TUP and TLO don't need it, or do it on their own).
+ */
+String builtinRandom(const int64_t minimum, const int64_t maximum, String * charset) {
+	flattenString(charset);
+	const size_t charsetLenght = charset->length;
+	String result = { 0 };
+
+	if (minimum > maximum || maximum <= 0 || minimum < 0 || charsetLenght == 0) {
+		destroyString(charset);
+		return result;
+	}
+	if (MAXIMUM_RANDOM_LENGTH < minimum) {
+		logError(_logger, "RND cannot build a string of %" PRId64 " characters (at most %d).", minimum, MAXIMUM_RANDOM_LENGTH);
+		destroyString(charset);
+		return result;
+	}
+
+	// The range is computed without overflow, even for the whole range of the
+	// atomic values.
+	const uint64_t range = (uint64_t) (maximum < MAXIMUM_RANDOM_LENGTH ? maximum : MAXIMUM_RANDOM_LENGTH) - (uint64_t) minimum + 1;
+	const size_t length = (size_t) minimum + (size_t) ((uint64_t) rand() % range);
+	const char * characters = getCharacters(charset);
+	char * destiny = allocateString(&result, length);
+
+	if (destiny != NULL) {
+		for (size_t i = 0; i < length; i++) {
+			destiny[i] = characters[rand() % charsetLenght];
+		}
+		result.ascii = charset->ascii;
+	}
+	destroyString(charset);
+
+	return result;
+}
+
+String builtinReverse(String * input) {
+	flattenString(input);
+	String result = { 0 };
+	char * characters;
+	if (input->length <= SHORT_STRING_CAPACITY || input->buffer->references == 1) {
+		// Nobody else sees the characters, so they are reversed in place.
+		result = *input;
+		characters = getMutableCharacters(&result);
+		reverse(characters, result.length);
+	}
+	else {
+		characters = allocateString(&result, input->length);
+		if (characters != NULL) {
+			reverseInto(characters, getCharacters(input), input->length);
+			result.ascii = input->ascii;
+		}
+		destroyString(input);
+	}
+	if (_reverseCodePoints && !result.ascii && characters != NULL) {
+		restoreCodePoints(characters, result.length);
+	}
+	return result;
+}
+
+/**
+ * In the "C" locale, only the ASCII letters have another case, so the
+ * kernels give the same result as "toupper" and "tolower".
+ */
+String builtinToUpper(String * input) {
+	char * characters = getMutableCharacters(input);
+	if (characters == NULL) {
+		// Out of memory, so the input is already empty.
+		return *input;
+	}
+	upperCase(characters, input->length);
+	return *input;
+}
+
+String builtinToLower(String * input) {
+	char * characters = getMutableCharacters(input);
+	if (characters == NULL) {
+		// Out of memory, so the input is already empty.
+		return *input;
+	}
+	lowerCase(characters, input->length);
+	return *input;
+}
+
+int64_t builtinLength(String * input) {
+	const int64_t length = input->length;
+	destroyString(input);
+
+	return length;
+}
+
+String builtinReplace(String * original, String * target, String * replacement) {
+	flattenString(target);
+	Finder finder;
+	prepareFinder(&finder, getCharacters(target), target->length);
+	String result = builtinReplaceWith(&finder, original, replacement);
+	destroyString(target);
+	return result;
+}
+
+/**
+ * The result is sized for a single occurrence first, and it grows (twice as
+ * big, at least) when there are more.
+ */
+String builtinReplaceWith(const Finder * target, String * original, String * replacement) {
+	flattenString(original);
+	const char * source = getCharacters(original);
+	const size_t length = original->length;
+	size_t match = findNext(target, source, length, 0);
+
+	if (match == NOT_FOUND) {
+		destroyString(replacement);
+		return *original;
+	}
+
+	flattenString(replacement);
+	const char * value = getCharacters(replacement);
+	const size_t valueLength = replacement->length;
+	String result = { 0 };
+	size_t capacity = length - target->length + valueLength;
+	size_t written = 0;
+	size_t position = 0;
+	char * destiny = allocateString(&result, capacity);
+
+	while (destiny != NULL && match != NOT_FOUND) {
+		const size_t bytes = match - position;
+		const size_t required = written + bytes + valueLength + (length - match - target->length);
+		if (capacity < required) {
+			capacity = required < 2 * capacity ? 2 * capacity : required;
+			if ((destiny = resizeString(&result, capacity)) == NULL) {
+				break;
+			}
+		}
+		memcpy(destiny + written, source + position, bytes);
+		written += bytes;
+		memcpy(destiny + written, value, valueLength);
+		written += valueLength;
+		position = match + target->length;
+		match = findNext(target, source, length, position);
+	}
+
+	if (destiny != NULL) {
+		memcpy(destiny + written, source + position, length - position);
+		resizeString(&result, written + length - position);
+		result.ascii = original->ascii && replacement->ascii;
+	}
+	destroyString(original);
+	destroyString(replacement);
+
+	return result;
+}
+
+/**
+ * The targets are only needed to build the automaton, and the replacements
+ * are packed behind the original.
+ */
+String builtinReplaceAll(String * original, String * pairs, const unsigned int count) {
+	Automaton * automaton = NULL;
+	const char ** targets = calloc(count, sizeof(char *));
+	size_t * lengths = targets == NULL ? NULL : calloc(count, sizeof(size_t));
+	if (lengths == NULL) {
+		logError(_logger, "Cannot allocate the %u targets of the automaton.", count);
+	}
+	else {
+		for (unsigned int k = 0; k < count; ++k) {
+			flattenString(&pairs[2 * k]);
+			targets[k] = getCharacters(&pairs[2 * k]);
+			lengths[k] = pairs[2 * k].length;
+		}
+		automaton = createAutomaton(targets, lengths, count);
+		if (automaton == NULL) {
+			logError(_logger, "Cannot build the automaton of %u targets.", count);
+		}
+	}
+	free(targets);
+	free(lengths);
+
+	for (unsigned int k = 0; k < count; ++k) {
+		destroyString(&pairs[2 * k]);
+		pairs[k] = pairs[2 * k + 1];
+	}
+	if (automaton == NULL) {
+		destroyString(original);
+		for (unsigned int k = 0; k < count; ++k) {
+			destroyString(&pairs[k]);
+		}
+		return (String) { 0 };
+	}
+	String result = builtinReplaceAllWith(automaton, original, pairs);
+	destroyAutomaton(automaton);
+	return result;
+}
+
+/**
+ * Like RPL, the result is sized for the original first, and it grows (twice
+ * as big, at least) when it's not enough.
+ */
+String builtinReplaceAllWith(const Automaton * targets, String * original, String * replacements) {
+	flattenString(original);
+	const char * source = getCharacters(original);
+	const size_t length = original->length;
+	unsigned int target = 0;
+	size_t match = findTarget(targets, source, length, 0, &target);
+
+	String result = *original;
+	if (match != NOT_FOUND) {
+		result = (String) { 0 };
+		size_t capacity = length;
+		size_t written = 0;
+		size_t position = 0;
+		boolean ascii = original->ascii;
+		char * destiny = allocateString(&result, capacity);
+
+		while (destiny != NULL && match != NOT_FOUND) {
+			String * replacement = &replacements[target];
+			flattenString(replacement);
+			const size_t end = match + targets->lengths[target];
+			const size_t bytes = match - position;
+			const size_t required = written + bytes + replacement->length + (length - end);
+			if (capacity < required) {
+				capacity = required < 2 * capacity ? 2 * capacity : required;
+				if ((destiny = resizeString(&result, capacity)) == NULL) {
+					break;
+				}
+			}
+			memcpy(destiny + written, source + position, bytes);
+			written += bytes;
+			memcpy(destiny + written, getCharacters(replacement), replacement->length);
+			written += replacement->length;
+			ascii = ascii && replacement->ascii;
+			position = end;
+			match = findTarget(targets, source, length, position, &target);
+		}
+
+		if (destiny != NULL) {
+			memcpy(destiny + written, source + position, length - position);
+			resizeString(&result, written + length - position);
+			result.ascii = ascii;
+		}
+		destroyString(original);
+	}
+	for (unsigned int k = 0; k < targets->targetCount; ++k) {
+		destroyString(&replacements[k]);
+	}
+
+	return result;
+}
+
+String builtinEncrypt(String * input, String * key) {
+	flattenString(input);
+	flattenString(key);
+	const size_t lenght = input->length;
+	const size_t keyLenght = key->length;
+	const size_t minimumLenght = lenght < keyLenght ? lenght : keyLenght;
+	const char * characters = getCharacters(input);
+	const char * keyCharacters = getCharacters(key);
+
+	unsigned char * xorResult = malloc(minimumLenght + 1);
+	if (xorResult == NULL) {
+		logError(_logger, "Cannot allocate the encrypted string.");
+		destroyString(input);
+		destroyString(key);
+		return (String) { 0 };
+	}
+
+	for (size_t i = 0; i < minimumLenght; ++i) {
+		xorResult[i] = characters[i] ^ keyCharacters[i % keyLenght];
+	}
+
+	size_t encodedLenght = 0;
+	char * encoded = base64_encode(xorResult, minimumLenght, &encodedLenght);
+	String result = encoded == NULL ? (String) { 0 } : createString(encoded, encodedLenght);
+
+	free(encoded);
+	free(xorResult);
+	destroyString(input);
+	destroyString(key);
+
+	return result;
+}
@@ -0,0 +1,113 @@
+#ifndef BUILTINS_HEADER
+#define BUILTINS_HEADER
+
+#include "../../frontend/syntactic-analysis/AbstractSyntaxTree.h"
+#include "../../shared/Environment.h"
+#include "../../shared/Logger.h"
+#include "../../shared/String.h"
+#include "../../shared/Type.h"
+#include "Automaton.h"
+#include "Finder.h"
+#include "Kernels.h"
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The builtin functions of the language, over strings (see "String.h") and
+ * atomic values. Every function takes the ownership of its string arguments,
+ * and returns a new string (or an atomic value), that may reuse one of them.
+ * They are shared by the virtual machine and by the constant folding, so a
+ * value computed during the compilation is the same that the execution would
+ * produce.
+ */
+
+/** Initialize module's internal state (see "REVERSE_MODE"). */
+void initializeBuiltinsModule();
+
+/** Shutdown module's internal state. */
+void shutdownBuiltinsModule();
+
+/** The size of a buffer that fits any atomic value in decimal. */
+#define ATOMIC_BUFFER_SIZE			24
+
+/** The longest string built by RND (16 MiB). */
+#define MAXIMUM_RANDOM_LENGTH		(16 * 1024 * 1024)
+
+/**
+ * Writes an atomic value in decimal into a buffer of ATOMIC_BUFFER_SIZE
+ * characters (not null-terminated), and returns its length. The values are
+ * converted only at the boundaries (the output, the interpolations, and the
+ * builtins over strings).
+ */
+size_t formatAtomic(const int64_t value, char * buffer);
+
+/**
+ * Reads the leading decimal number of a string, like "atoi" (so it's zero
+ * if there is none).
+ */
+int64_t parseAtomic(const char * string);
+
+/**
+ * The arithmetic over atomic values (64-bit signed integers). The division
+ * truncates toward zero. Returns false, and leaves the result untouched, if
+ * it overflows or if it divides by zero.
+ */
+boolean builtinArithmetic(const ArithmeticOperator operator, const int64_t left, const int64_t right, int64_t * result);
+
+/**
+ * RND: a random string of a random length between "minimum" and "maximum".
+ * The maximum is clamped to MAXIMUM_RANDOM_LENGTH, and a longer minimum gives
+ * an empty string.
+ */
+String builtinRandom(const int64_t minimum, const int64_t maximum, String * charset);
+
+/**
+ * REV: the characters in reverse order. They are bytes, unless the mode is
+ * "UTF8", where the code points are reversed instead. The string is reversed
+ * in place when it's not shared.
+ */
+String builtinReverse(String * input);
+
+/** TUP: the upper-case version. */
+String builtinToUpper(String * input);
+
+/** TLO: the lower-case version. */
+String builtinToLower(String * input);
+
+/** LEN: the amount of characters (it's cached, so it's constant-time). */
+int64_t builtinLength(String * input);
+
+/** RPL: every occurrence of a target, replaced. */
+String builtinReplace(String * original, String * target, String * replacement);
+
+/**
+ * RPL, with the search of its target already prepared (e.g., during the
+ * compilation, if it's a constant). The original is scanned once, and left
+ * untouched if the target is not found.
+ */
+String builtinReplaceWith(const Finder * target, String * original, String * replacement);
+
+/**
+ * MRP: the occurrences of many targets, replaced in a single pass. The pairs
+ * are the targets and their replacements, interleaved.
+ */
+String builtinReplaceAll(String * original, String * pairs, const unsigned int count);
+
+/**
+ * MRP, with the automaton of its targets already built (e.g., during the
+ * compilation, if they are constants), and a replacement for each of them.
+ * The original is scanned once: a target is replaced as soon as it ends (the
+ * longest one, if many end at the same character), and the scan goes on
+ * behind it, so the replacements are never replaced again. It's left
+ * untouched if no target is found.
+ */
+String builtinReplaceAllWith(const Automaton * targets, String * original, String * replacements);
+
+/** ECP: the input "xored" with a key, in Base64. */
+String builtinEncrypt(String * input, String * key);
+
+#endif
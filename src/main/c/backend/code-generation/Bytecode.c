@@ -0,0 +1,844 @@
+#include "Bytecode.h"
+
+#define INITIAL_CODE_CAPACITY			256
+#define INITIAL_CONSTANT_CAPACITY		64
+#define INITIAL_FINDER_CAPACITY			8
+#define INITIAL_AUTOMATON_CAPACITY		4
+
+/* MODULE INTERNAL STATE */
+
+static Logger * _logger = NULL;
+
+/**
+ * The state of a single compilation. It's owned by the call (or by the
+ * caller, in streaming mode), so many programs can be compiled at the same
+ * time.
+ */
+struct BytecodeCompiler {
+	SymbolTable * symbolTable;
+	Interner * interner;
+	const Expression * expressions;
+	BytecodeProgram * bytecodeProgram;
+	unsigned int stackDepth;
+	unsigned int emptyConstant;
+	unsigned int unknownConstant;
+	unsigned int newLineConstant;
+
+	// Set when the code or the constant pool cannot grow, so the rest of the
+	// compilation is discarded.
+	boolean outOfMemory;
+
+	// In streaming mode, the code and constants that survive the statement
+	// that was run last (the routines, and the initial constants).
+	unsigned int retainedCodeSize;
+	unsigned int retainedConstantCount;
+	unsigned int retainedFinderCount;
+	unsigned int retainedAutomatonCount;
+};
+
+void initializeBytecodeModule() {
+	_logger = createLogger("Bytecode");
+}
+
+void shutdownBytecodeModule() {
+	if (_logger != NULL) {
+		destroyLogger(_logger);
+	}
+}
+
+//------------------------------------------------------------------------------------------------------
+
+/** PRIVATE FUNCTIONS */
+
+static BytecodeProgram * _createBytecodeProgram();
+static void _initializeCompiler(BytecodeCompiler * compiler, BytecodeProgram * bytecodeProgram, SymbolTable * symbolTable, Interner * interner);
+static boolean _reserveSlots(BytecodeCompiler * compiler);
+static boolean _compileStatementList(BytecodeCompiler * compiler, StatementList * list);
+static boolean _compileStatement(BytecodeCompiler * compiler, Statement * statement);
+static boolean _compileDeclaration(BytecodeCompiler * compiler, Declaration * declaration);
+static boolean _compileRoutine(BytecodeCompiler * compiler, Routine * routine);
+static boolean _compileExpression(BytecodeCompiler * compiler, const ExpressionId id);
+static boolean _compileExpressionAs(BytecodeCompiler * compiler, const ExpressionId id, const ConstantType type);
+static boolean _compileOperands(BytecodeCompiler * compiler, const Expression * expression, const unsigned int count);
+static boolean _compileArithmetic(BytecodeCompiler * compiler, const Expression * expression);
+static boolean _compileInterpolation(BytecodeCompiler * compiler, Interpolation * interpolation);
+static boolean _compileFragment(BytecodeCompiler * compiler, InterpolationFragment * fragment, uint32_t * operand);
+static boolean _compileIdentifier(BytecodeCompiler * compiler, const Expression * expression);
+static boolean _compileOutput(BytecodeCompiler * compiler, const ExpressionId id);
+static boolean _compileOutputInterpolation(BytecodeCompiler * compiler, Interpolation * interpolation);
+static boolean _compileReplace(BytecodeCompiler * compiler, const Expression * expression);
+static boolean _compileMultipleReplace(BytecodeCompiler * compiler, const Expression * expression);
+
+static unsigned int _addConstant(BytecodeCompiler * compiler, const char * value);
+static unsigned int _addAtomicConstant(BytecodeCompiler * compiler, const int64_t value);
+static void _destroyFinders(BytecodeProgram * bytecodeProgram, const unsigned int count);
+static void _destroyAutomata(BytecodeProgram * bytecodeProgram, const unsigned int count);
+static ConstantType _typeOf(BytecodeCompiler * compiler, const ExpressionId id);
+static void _emit(BytecodeCompiler * compiler, const Opcode opcode, const int stackEffect);
+static void _emitWithOperand(BytecodeCompiler * compiler, const Opcode opcode, const uint32_t operand, const int stackEffect);
+static void _emitAtomic(BytecodeCompiler * compiler, const int64_t value);
+static void _emitWord(BytecodeCompiler * compiler, const uint32_t word);
+
+//------------------------------------------------------------------------------------------------------
+
+static BytecodeProgram * _createBytecodeProgram() {
+	BytecodeProgram * bytecodeProgram = calloc(1, sizeof(BytecodeProgram));
+	if (bytecodeProgram == NULL) {
+		return NULL;
+	}
+	bytecodeProgram->codeCapacity = INITIAL_CODE_CAPACITY;
+	bytecodeProgram->code = malloc(bytecodeProgram->codeCapacity * sizeof(uint32_t));
+	bytecodeProgram->constantCapacity = INITIAL_CONSTANT_CAPACITY;
+	bytecodeProgram->constants = malloc(bytecodeProgram->constantCapacity * sizeof(char *));
+	bytecodeProgram->constantLengths = malloc(bytecodeProgram->constantCapacity * sizeof(size_t));
+	bytecodeProgram->finderCapacity = INITIAL_FINDER_CAPACITY;
+	bytecodeProgram->finders = malloc(bytecodeProgram->finderCapacity * sizeof(Finder *));
+	bytecodeProgram->automatonCapacity = INITIAL_AUTOMATON_CAPACITY;
+	bytecodeProgram->automata = malloc(bytecodeProgram->automatonCapacity * sizeof(Automaton *));
+	bytecodeProgram->routineEntries = malloc(sizeof(int));
+	bytecodeProgram->slotTypes = malloc(sizeof(ConstantType));
+	if (bytecodeProgram->code == NULL || bytecodeProgram->constants == NULL || bytecodeProgram->constantLengths == NULL
+		|| bytecodeProgram->finders == NULL || bytecodeProgram->automata == NULL
+		|| bytecodeProgram->routineEntries == NULL || bytecodeProgram->slotTypes == NULL) {
+		destroyBytecodeProgram(bytecodeProgram);
+		return NULL;
+	}
+	return bytecodeProgram;
+}
+
+/**
+ * Binds a compiler to an empty program, and adds the constants that every
+ * program needs.
+ */
+static void _initializeCompiler(BytecodeCompiler * compiler, BytecodeProgram * bytecodeProgram, SymbolTable * symbolTable, Interner * interner) {
+	compiler->symbolTable = symbolTable;
+	compiler->interner = interner;
+	compiler->expressions = NULL;
+	compiler->bytecodeProgram = bytecodeProgram;
+	compiler->stackDepth = 0;
+	compiler->outOfMemory = false;
+	compiler->emptyConstant = _addConstant(compiler, "");
+	compiler->unknownConstant = _addConstant(compiler, "<?>");
+	compiler->newLineConstant = _addConstant(compiler, "\n");
+	compiler->retainedCodeSize = 0;
+	compiler->retainedConstantCount = bytecodeProgram->constantCount;
+	compiler->retainedFinderCount = 0;
+	compiler->retainedAutomatonCount = 0;
+}
+
+/**
+ * Makes room for the slots of every symbol defined so far. The new ones are
+ * variables, until a routine gets compiled into them, and only the atomic
+ * variables hold atomic values.
+ */
+static boolean _reserveSlots(BytecodeCompiler * compiler) {
+	BytecodeProgram * program = compiler->bytecodeProgram;
+	const unsigned int slotCount = getSymbolCount(compiler->symbolTable);
+	if (slotCount <= program->slotCount) {
+		return true;
+	}
+
+	int * routineEntries = realloc(program->routineEntries, (1 + slotCount) * sizeof(int));
+	if (routineEntries != NULL) {
+		program->routineEntries = routineEntries;
+	}
+	ConstantType * slotTypes = realloc(program->slotTypes, (1 + slotCount) * sizeof(ConstantType));
+	if (slotTypes != NULL) {
+		program->slotTypes = slotTypes;
+	}
+	if (routineEntries == NULL || slotTypes == NULL) {
+		logError(_logger, "Cannot reserve %u slots.", slotCount);
+		return false;
+	}
+	for (unsigned int k = program->slotCount; k < slotCount; ++k) {
+		Symbol * symbol = getSymbolAt(compiler->symbolTable, k);
+		routineEntries[k] = -1;
+		slotTypes[k] = symbol->kind == VARIABLE_SYMBOL && symbol->variable.type == ATOMIC_TYPE ? ATOMIC_TYPE : STRING_TYPE;
+	}
+	program->slotCount = slotCount;
+	return true;
+}
+
+/**
+ * Appends a raw word to the instruction stream, growing it if needed. If it
+ * cannot grow, the word is dropped and the compilation fails at the end.
+ */
+static void _emitWord(BytecodeCompiler * compiler, const uint32_t word) {
+	BytecodeProgram * program = compiler->bytecodeProgram;
+	if (program->codeSize == program->codeCapacity) {
+		uint32_t * code = realloc(program->code, 2 * program->codeCapacity * sizeof(uint32_t));
+		if (code == NULL) {
+			if (!compiler->outOfMemory) {
+				logError(_logger, "Cannot grow the code beyond %u words.", program->codeCapacity);
+			}
+			compiler->outOfMemory = true;
+			return;
+		}
+		program->code = code;
+		program->codeCapacity *= 2;
+	}
+	program->code[program->codeSize++] = word;
+}
+
+/**
+ * Emits an instruction, and tracks the depth of the operand stack after it
+ * runs, so the virtual machine can allocate the stack only once.
+ */
+static void _emit(BytecodeCompiler * compiler, const Opcode opcode, const int stackEffect) {
+	_emitWord(compiler, opcode);
+	compiler->stackDepth += stackEffect;
+	if (compiler->bytecodeProgram->maximumStackDepth < compiler->stackDepth) {
+		compiler->bytecodeProgram->maximumStackDepth = compiler->stackDepth;
+	}
+}
+
+static void _emitWithOperand(BytecodeCompiler * compiler, const Opcode opcode, const uint32_t operand, const int stackEffect) {
+	_emit(compiler, opcode, stackEffect);
+	_emitWord(compiler, operand);
+}
+
+/**
+ * Pushes an atomic value, split in two words (the low one first).
+ */
+static void _emitAtomic(BytecodeCompiler * compiler, const int64_t value) {
+	_emitWithOperand(compiler, OP_PUSH_ATOMIC, (uint32_t) value, 1);
+	_emitWord(compiler, (uint32_t) ((uint64_t) value >> 32));
+}
+
+/**
+ * Adds a value to the constant pool, and returns its index. The pool only
+ * holds the interned copy of the value, so it never duplicates a literal.
+ * If the pool cannot grow, the compilation fails at the end (and the index
+ * of the first constant is returned meanwhile).
+ */
+static unsigned int _addConstant(BytecodeCompiler * compiler, const char * value) {
+	BytecodeProgram * program = compiler->bytecodeProgram;
+	if (program->constantCount == program->constantCapacity) {
+		const char ** constants = realloc(program->constants, 2 * program->constantCapacity * sizeof(char *));
+		if (constants != NULL) {
+			program->constants = constants;
+		}
+		size_t * constantLengths = realloc(program->constantLengths, 2 * program->constantCapacity * sizeof(size_t));
+		if (constantLengths != NULL) {
+			program->constantLengths = constantLengths;
+		}
+		if (constants == NULL || constantLengths == NULL) {
+			if (!compiler->outOfMemory) {
+				logError(_logger, "Cannot grow the constant pool beyond %u constants.", program->constantCapacity);
+			}
+			compiler->outOfMemory = true;
+			return 0;
+		}
+		program->constantCapacity *= 2;
+	}
+	program->constants[program->constantCount] = internString(compiler->interner, value == NULL ? "" : value);
+	program->constantLengths[program->constantCount] = strlen(program->constants[program->constantCount]);
+	return program->constantCount++;
+}
+
+/**
+ * Atomic constants used as strings are formatted only once, during
+ * compilation.
+ */
+static unsigned int _addAtomicConstant(BytecodeCompiler * compiler, const int64_t value) {
+	char buffer[ATOMIC_BUFFER_SIZE + 1];
+	buffer[formatAtomic(value, buffer)] = '\0';
+	return _addConstant(compiler, buffer);
+}
+
+/**
+ * Destroys the finders of a program, but the first ones.
+ */
+static void _destroyFinders(BytecodeProgram * bytecodeProgram, const unsigned int count) {
+	while (count < bytecodeProgram->finderCount) {
+		free(bytecodeProgram->finders[--bytecodeProgram->finderCount]);
+	}
+}
+
+/**
+ * Destroys the automata of a program, but the first ones.
+ */
+static void _destroyAutomata(BytecodeProgram * bytecodeProgram, const unsigned int count) {
+	while (count < bytecodeProgram->automatonCount) {
+		destroyAutomaton(bytecodeProgram->automata[--bytecodeProgram->automatonCount]);
+	}
+}
+
+/**
+ * The type of the value of an expression (the missing ones are empty
+ * strings).
+ */
+static ConstantType _typeOf(BytecodeCompiler * compiler, const ExpressionId id) {
+	return id == NO_EXPRESSION ? STRING_TYPE : compiler->expressions[id].valueType;
+}
+
+static boolean _compileStatementList(BytecodeCompiler * compiler, StatementList * list) {
+	if (!list) { return true; }
+
+	for (unsigned int k = 0; k < list->count; ++k) {
+		if (!_compileStatement(compiler, list->statements[k])) { return false; }
+	}
+	return true;
+}
+
+static boolean _compileStatement(BytecodeCompiler * compiler, Statement * statement) {
+	if (!statement) { return false; }
+
+	compiler->bytecodeProgram->statementCount++;
+
+	switch (statement->type) {
+		case STATEMENT_DECLARATION:
+			return _compileDeclaration(compiler, statement->declaration);
+		case STATEMENT_OUTPUT:
+			return _compileOutput(compiler, statement->expression);
+		case STATEMENT_EXPRESSION:
+			if (!_compileExpression(compiler, statement->expression)) { return false; }
+			_emit(compiler, _typeOf(compiler, statement->expression) == ATOMIC_TYPE ? OP_POP_ATOMIC : OP_POP, -1);
+			return true;
+		case STATEMENT_ROUTINE:
+			return _compileRoutine(compiler, statement->routine);
+		case STATEMENT_ROUTINE_CALL:
+			if (statement->routineCallSlot == UNRESOLVED_SLOT) {
+				logError(_logger, "Unresolved routine: '%s'", statement->routineCallName);
+				return false;
+			}
+			_emitWithOperand(compiler, OP_CALL, statement->routineCallSlot, 0);
+			return true;
+		default:
+			logError(_logger, "Unsupported statement type for compilation.");
+			return false;
+	}
+}
+
+static boolean _compileDeclaration(BytecodeCompiler * compiler, Declaration * declaration) {
+	if (declaration->slot == UNRESOLVED_SLOT) {
+		logError(_logger, "Unresolved identifier: '%s'", declaration->identifier);
+		return false;
+	}
+
+	switch (declaration->type) {
+		case STRING_TYPE:
+			if (!_compileExpressionAs(compiler, declaration->expression, STRING_TYPE)) { return false; }
+			_emitWithOperand(compiler, OP_STORE, declaration->slot, -1);
+			return true;
+		case ATOMIC_TYPE:
+			if (!_compileExpressionAs(compiler, declaration->expression, ATOMIC_TYPE)) { return false; }
+			_emitWithOperand(compiler, OP_STORE_ATOMIC, declaration->slot, -1);
+			return true;
+		default:
+			logWarning(_logger, "Unhandled declaration type");
+			return true;
+	}
+}
+
+/**
+ * The body of a routine is placed inline, behind a jump, so defining a
+ * routine has no cost at runtime.
+ */
+static boolean _compileRoutine(BytecodeCompiler * compiler, Routine * routine) {
+	if (routine->slot == UNRESOLVED_SLOT) {
+		logError(_logger, "Unresolved routine: '%s'", routine->identifier);
+		return false;
+	}
+
+	_emitWithOperand(compiler, OP_JUMP, 0, 0);
+	const unsigned int jumpOperand = compiler->bytecodeProgram->codeSize - 1;
+
+	compiler->bytecodeProgram->routineEntries[routine->slot] = compiler->bytecodeProgram->codeSize;
+	if (!_compileStatementList(compiler, routine->body)) { return false; }
+	_emit(compiler, OP_RETURN, 0);
+
+	compiler->bytecodeProgram->code[jumpOperand] = compiler->bytecodeProgram->codeSize;
+	return true;
+}
+
+static boolean _compileExpression(BytecodeCompiler * compiler, const ExpressionId id) {
+	if (id == NO_EXPRESSION) {
+		_emitWithOperand(compiler, OP_PUSH_CONSTANT, compiler->emptyConstant, 1);
+		return true;
+	}
+
+	const Expression * expression = &compiler->expressions[id];
+	switch (expression->type) {
+		case ATOMIC_CONSTANT_EXPRESSION:
+			_emitAtomic(compiler, expression->atomic);
+			return true;
+		case STRING_CONSTANT_EXPRESSION:
+			_emitWithOperand(compiler, OP_PUSH_CONSTANT, _addConstant(compiler, expression->string), 1);
+			return true;
+		case BUFFER_CONSTANT_EXPRESSION:
+			_emitWithOperand(compiler, OP_PUSH_CONSTANT, compiler->emptyConstant, 1);
+			return true;
+		case IDENTIFIER_EXPRESSION:
+			return _compileIdentifier(compiler, expression);
+		case INTERPOLATION_EXPRESSION:
+			return _compileInterpolation(compiler, expression->interpolation);
+		case ARITHMETIC_EXPRESSION:
+			return _compileArithmetic(compiler, expression);
+		case EXPRESSION_RND:
+			if (!_compileExpressionAs(compiler, expression->operands[0], ATOMIC_TYPE)
+				|| !_compileExpressionAs(compiler, expression->operands[1], ATOMIC_TYPE)
+				|| !_compileExpressionAs(compiler, expression->operands[2], STRING_TYPE)) {
+				return false;
+			}
+			_emit(compiler, OP_RND, -2);
+			return true;
+		case EXPRESSION_REV:
+			if (!_compileOperands(compiler, expression, 1)) { return false; }
+			_emit(compiler, OP_REV, 0);
+			return true;
+		case EXPRESSION_TUP:
+			if (!_compileOperands(compiler, expression, 1)) { return false; }
+			_emit(compiler, OP_TUP, 0);
+			return true;
+		case EXPRESSION_TLO:
+			if (!_compileOperands(compiler, expression, 1)) { return false; }
+			_emit(compiler, OP_TLO, 0);
+			return true;
+		case EXPRESSION_LEN:
+			if (!_compileOperands(compiler, expression, 1)) { return false; }
+			_emit(compiler, OP_LEN, 0);
+			return true;
+		case EXPRESSION_RPL:
+			return _compileReplace(compiler, expression);
+		case EXPRESSION_MRP:
+			return _compileMultipleReplace(compiler, expression);
+		case EXPRESSION_ECP:
+			if (!_compileOperands(compiler, expression, 2)) { return false; }
+			_emit(compiler, OP_ECP, -1);
+			return true;
+		default:
+			logError(_logger, "Unsupported expression type.");
+			return false;
+	}
+}
+
+/**
+ * Pushes an expression, converted to a type if needed. The constants are
+ * converted during compilation.
+ */
+static boolean _compileExpressionAs(BytecodeCompiler * compiler, const ExpressionId id, const ConstantType type) {
+	const ConstantType actualType = _typeOf(compiler, id);
+	if (actualType == type) {
+		return _compileExpression(compiler, id);
+	}
+
+	const Expression * expression = id == NO_EXPRESSION ? NULL : &compiler->expressions[id];
+	if (expression != NULL && expression->type == ATOMIC_CONSTANT_EXPRESSION) {
+		_emitWithOperand(compiler, OP_PUSH_CONSTANT, _addAtomicConstant(compiler, expression->atomic), 1);
+		return true;
+	}
+	if (expression != NULL && expression->type == STRING_CONSTANT_EXPRESSION) {
+		_emitAtomic(compiler, parseAtomic(expression->string == NULL ? "" : expression->string));
+		return true;
+	}
+	if (!_compileExpression(compiler, id)) { return false; }
+	_emit(compiler, type == ATOMIC_TYPE ? OP_TO_ATOMIC : OP_TO_STRING, 0);
+	return true;
+}
+
+/**
+ * Pushes the first operands of an expression as strings, in order.
+ */
+static boolean _compileOperands(BytecodeCompiler * compiler, const Expression * expression, const unsigned int count) {
+	for (unsigned int k = 0; k < count; ++k) {
+		if (!_compileExpressionAs(compiler, expression->operands[k], STRING_TYPE)) { return false; }
+	}
+	return true;
+}
+
+/**
+ * The search of a constant target is prepared only once, here, instead of
+ * on every execution.
+ */
+static boolean _compileReplace(BytecodeCompiler * compiler, const Expression * expression) {
+	const ExpressionId target = expression->operands[1];
+	if (target == NO_EXPRESSION || compiler->expressions[target].type != STRING_CONSTANT_EXPRESSION) {
+		if (!_compileOperands(compiler, expression, 3)) { return false; }
+		_emit(compiler, OP_RPL, -2);
+		return true;
+	}
+
+	BytecodeProgram * program = compiler->bytecodeProgram;
+	if (program->finderCount == program->finderCapacity) {
+		Finder ** finders = realloc(program->finders, 2 * program->finderCapacity * sizeof(Finder *));
+		if (finders == NULL) { return false; }
+		program->finders = finders;
+		program->finderCapacity *= 2;
+	}
+	Finder * finder = malloc(sizeof(Finder));
+	if (finder == NULL) {
+		logError(_logger, "Cannot prepare the search of a constant target.");
+		return false;
+	}
+	const char * needle = compiler->expressions[target].string;
+	needle = internString(compiler->interner, needle == NULL ? "" : needle);
+	prepareFinder(finder, needle, strlen(needle));
+	const unsigned int index = program->finderCount++;
+	program->finders[index] = finder;
+
+	if (!_compileExpressionAs(compiler, expression->operands[0], STRING_TYPE)
+		|| !_compileExpressionAs(compiler, expression->operands[2], STRING_TYPE)) {
+		return false;
+	}
+	_emitWithOperand(compiler, OP_RPL_CONSTANT, index, -1);
+	return true;
+}
+
+/**
+ * Like RPL, the automaton of the targets is built only once, here, if all of
+ * them are constants. Otherwise, it's built on every execution.
+ */
+static boolean _compileMultipleReplace(BytecodeCompiler * compiler, const Expression * expression) {
+	unsigned int count = 0;
+	boolean constant = true;
+	for (ExpressionId pair = expression->operands[1]; pair != NO_EXPRESSION; pair = compiler->expressions[pair].operands[2]) {
+		const ExpressionId target = compiler->expressions[pair].operands[0];
+		constant = constant && target != NO_EXPRESSION && compiler->expressions[target].type == STRING_CONSTANT_EXPRESSION;
+		++count;
+	}
+
+	if (!constant) {
+		if (!_compileExpressionAs(compiler, expression->operands[0], STRING_TYPE)) { return false; }
+		for (ExpressionId pair = expression->operands[1]; pair != NO_EXPRESSION; pair = compiler->expressions[pair].operands[2]) {
+			if (!_compileOperands(compiler, &compiler->expressions[pair], 2)) { return false; }
+		}
+		_emitWithOperand(compiler, OP_MRP, count, -2 * (int) count);
+		return true;
+	}
+
+	BytecodeProgram * program = compiler->bytecodeProgram;
+	if (program->automatonCount == program->automatonCapacity) {
+		Automaton ** automata = realloc(program->automata, 2 * program->automatonCapacity * sizeof(Automaton *));
+		if (automata == NULL) { return false; }
+		program->automata = automata;
+		program->automatonCapacity *= 2;
+	}
+	const char ** targets = malloc(count * sizeof(char *));
+	size_t * lengths = malloc(count * sizeof(size_t));
+	unsigned int k = 0;
+	for (ExpressionId pair = expression->operands[1]; targets != NULL && lengths != NULL && pair != NO_EXPRESSION; pair = compiler->expressions[pair].operands[2]) {
+		const char * target = compiler->expressions[compiler->expressions[pair].operands[0]].string;
+		targets[k] = target == NULL ? "" : target;
+		lengths[k] = strlen(targets[k]);
+		++k;
+	}
+	Automaton * automaton = targets == NULL || lengths == NULL ? NULL : createAutomaton(targets, lengths, count);
+	free(targets);
+	free(lengths);
+	if (automaton == NULL) {
+		logError(_logger, "Cannot build the automaton of %u constant targets.", count);
+		return false;
+	}
+	const unsigned int index = program->automatonCount++;
+	program->automata[index] = automaton;
+
+	if (!_compileExpressionAs(compiler, expression->operands[0], STRING_TYPE)) { return false; }
+	for (ExpressionId pair = expression->operands[1]; pair != NO_EXPRESSION; pair = compiler->expressions[pair].operands[2]) {
+		if (!_compileExpressionAs(compiler, compiler->expressions[pair].operands[1], STRING_TYPE)) { return false; }
+	}
+	_emitWithOperand(compiler, OP_MRP_CONSTANT, index, -(int) count);
+	return true;
+}
+
+/**
+ * The operands stay atomic (unboxed) along a chain of operations, and get
+ * converted only where the result is used as a string. An addition with a
+ * string operand is a concatenation.
+ */
+static boolean _compileArithmetic(BytecodeCompiler * compiler, const Expression * expression) {
+	if (expression->valueType == STRING_TYPE) {
+		if (!_compileOperands(compiler, expression, 2)) { return false; }
+		_emit(compiler, OP_CONCATENATE, -1);
+		return true;
+	}
+	if (!_compileExpressionAs(compiler, expression->operands[0], ATOMIC_TYPE)
+		|| !_compileExpressionAs(compiler, expression->operands[1], ATOMIC_TYPE)) {
+		return false;
+	}
+	switch (expression->operator) {
+		case ADDITION:
+			_emit(compiler, OP_ADD, -1);
+			return true;
+		case SUBTRACTION:
+			_emit(compiler, OP_SUBTRACT, -1);
+			return true;
+		case MULTIPLICATION:
+			_emit(compiler, OP_MULTIPLY, -1);
+			return true;
+		case DIVISION:
+			_emit(compiler, OP_DIVIDE, -1);
+			return true;
+		default:
+			logError(_logger, "Unknown arithmetic operator.");
+			return false;
+	}
+}
+
+/**
+ * An interpolation is joined by a single instruction that references its
+ * fragments in place (constants and variables), so the result is built with
+ * one allocation, and no fragment is copied twice. A single fragment is just
+ * pushed.
+ */
+static boolean _compileInterpolation(BytecodeCompiler * compiler, Interpolation * interpolation) {
+	unsigned int count = 0;
+	for (InterpolationFragmentList * current = interpolation ? interpolation->fragments : NULL; current; current = current->next) {
+		++count;
+	}
+
+	if (count == 0) {
+		_emitWithOperand(compiler, OP_PUSH_CONSTANT, compiler->emptyConstant, 1);
+		return true;
+	}
+	if (count == 1) {
+		uint32_t operand = 0;
+		if (!_compileFragment(compiler, interpolation->fragments->head, &operand)) { return false; }
+		if (operand & FRAGMENT_ATOMIC_FLAG) {
+			_emitWithOperand(compiler, OP_LOAD_ATOMIC, operand & FRAGMENT_OPERAND_MASK, 1);
+			_emit(compiler, OP_TO_STRING, 0);
+		}
+		else if (operand & FRAGMENT_SLOT_FLAG) {
+			_emitWithOperand(compiler, OP_LOAD, operand & FRAGMENT_OPERAND_MASK, 1);
+		}
+		else {
+			_emitWithOperand(compiler, OP_PUSH_CONSTANT, operand, 1);
+		}
+		return true;
+	}
+
+	_emitWithOperand(compiler, OP_INTERPOLATE, count, 1);
+	for (InterpolationFragmentList * current = interpolation->fragments; current; current = current->next) {
+		uint32_t operand = 0;
+		if (!_compileFragment(compiler, current->head, &operand)) { return false; }
+		_emitWord(compiler, operand);
+	}
+	return true;
+}
+
+/**
+ * Resolves a fragment of an interpolation into an operand: the index of a
+ * constant, or the slot of a variable (flagged with FRAGMENT_SLOT_FLAG, and
+ * FRAGMENT_ATOMIC_FLAG if it's atomic).
+ * Routines and unsupported types are rendered as the unknown constant.
+ */
+static boolean _compileFragment(BytecodeCompiler * compiler, InterpolationFragment * fragment, uint32_t * operand) {
+	if (fragment->type == LITERAL_FRAGMENT) {
+		*operand = _addConstant(compiler, fragment->literal);
+		return true;
+	}
+	if (fragment->type != EXPRESSION_FRAGMENT) {
+		logError(_logger, "Unknown interpolation fragment.");
+		return false;
+	}
+
+	Symbol * symbol = getSymbolAt(compiler->symbolTable, fragment->slot);
+
+	if (!symbol) {
+		logError(_logger, "Unresolved identifier: '%s'", fragment->identifier);
+		return false;
+	}
+
+	if (symbol->kind == VARIABLE_SYMBOL && symbol->variable.type == STRING_TYPE) {
+		*operand = FRAGMENT_SLOT_FLAG | symbol->slot;
+	}
+	else if (symbol->kind == VARIABLE_SYMBOL && symbol->variable.type == ATOMIC_TYPE) {
+		*operand = FRAGMENT_SLOT_FLAG | FRAGMENT_ATOMIC_FLAG | symbol->slot;
+	}
+	else {
+		if (symbol->kind == VARIABLE_SYMBOL) {
+			logWarning(_logger, "Unsupported type in interpolation for '%s'", fragment->identifier);
+		}
+		*operand = compiler->unknownConstant;
+	}
+	return true;
+}
+
+/**
+ * Variables are read from their slot. Inside an expression, a routine name
+ * calls the routine and evaluates to an empty string.
+ */
+static boolean _compileIdentifier(BytecodeCompiler * compiler, const Expression * expression) {
+	const char * identifier = expression->identifier;
+	Symbol * symbol = getSymbolAt(compiler->symbolTable, expression->slot);
+
+	if (!symbol) {
+		logError(_logger, "Unresolved identifier: '%s'", identifier);
+		return false;
+	}
+
+	if (symbol->kind == VARIABLE_SYMBOL) {
+		if (symbol->variable.type == STRING_TYPE) {
+			_emitWithOperand(compiler, OP_LOAD, symbol->slot, 1);
+		}
+		else if (symbol->variable.type == ATOMIC_TYPE) {
+			_emitWithOperand(compiler, OP_LOAD_ATOMIC, symbol->slot, 1);
+		}
+		else {
+			logWarning(_logger, "Unsupported type for '%s'", identifier);
+			_emitWithOperand(compiler, OP_PUSH_CONSTANT, compiler->unknownConstant, 1);
+		}
+	}
+	else if (symbol->kind == ROUTINE_SYMBOL) {
+		_emitWithOperand(compiler, OP_CALL, symbol->slot, 0);
+		_emitWithOperand(compiler, OP_PUSH_CONSTANT, compiler->emptyConstant, 1);
+	}
+	else {
+		_emitWithOperand(compiler, OP_PUSH_CONSTANT, compiler->unknownConstant, 1);
+	}
+	return true;
+}
+
+/**
+ * Constants and interpolations are streamed to the output piece by piece:
+ * the literals are referenced from the constant pool (never copied), and the
+ * variables are written straight from their slots. Any other expression is
+ * evaluated first.
+ */
+static boolean _compileOutput(BytecodeCompiler * compiler, const ExpressionId id) {
+	const Expression * expression = id == NO_EXPRESSION ? NULL : &compiler->expressions[id];
+
+	if (expression != NULL && expression->type == INTERPOLATION_EXPRESSION) {
+		if (!_compileOutputInterpolation(compiler, expression->interpolation)) { return false; }
+	}
+	else if (expression != NULL && expression->type == STRING_CONSTANT_EXPRESSION) {
+		_emitWithOperand(compiler, OP_WRITE_CONSTANT, _addConstant(compiler, expression->string), 0);
+	}
+	else if (expression != NULL && expression->type == ATOMIC_CONSTANT_EXPRESSION) {
+		_emitWithOperand(compiler, OP_WRITE_CONSTANT, _addAtomicConstant(compiler, expression->atomic), 0);
+	}
+	else {
+		if (!_compileExpression(compiler, id)) { return false; }
+		_emit(compiler, _typeOf(compiler, id) == ATOMIC_TYPE ? OP_OUT_ATOMIC : OP_OUT, -1);
+		return true;
+	}
+
+	_emitWithOperand(compiler, OP_WRITE_CONSTANT, compiler->newLineConstant, 0);
+	return true;
+}
+
+/**
+ * Like "_compileInterpolation", but every fragment goes to the output in
+ * source order, without joining them first.
+ */
+static boolean _compileOutputInterpolation(BytecodeCompiler * compiler, Interpolation * interpolation) {
+	for (InterpolationFragmentList * current = interpolation ? interpolation->fragments : NULL; current; current = current->next) {
+		uint32_t operand = 0;
+		if (!_compileFragment(compiler, current->head, &operand)) { return false; }
+		if (operand & FRAGMENT_ATOMIC_FLAG) {
+			_emitWithOperand(compiler, OP_WRITE_ATOMIC_SLOT, operand & FRAGMENT_OPERAND_MASK, 0);
+		}
+		else if (operand & FRAGMENT_SLOT_FLAG) {
+			_emitWithOperand(compiler, OP_WRITE_SLOT, operand & FRAGMENT_OPERAND_MASK, 0);
+		}
+		else {
+			_emitWithOperand(compiler, OP_WRITE_CONSTANT, operand, 0);
+		}
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------------------------------
+
+/** PUBLIC FUNCTIONS */
+
+BytecodeProgram * compileProgram(Program * program, SymbolTable * symbolTable, Interner * interner) {
+	logDebugging(_logger, "Compiling to bytecode...");
+
+	BytecodeProgram * bytecodeProgram = _createBytecodeProgram();
+	if (bytecodeProgram == NULL) {
+		logError(_logger, "Cannot allocate the bytecode program.");
+		return NULL;
+	}
+	BytecodeCompiler state;
+	BytecodeCompiler * compiler = &state;
+	_initializeCompiler(compiler, bytecodeProgram, symbolTable, interner);
+	compiler->expressions = program != NULL && program->expressions != NULL ? program->expressions->expressions : NULL;
+
+	boolean succeed = _reserveSlots(compiler) && (program == NULL || _compileStatementList(compiler, program->statements));
+	_emit(compiler, OP_HALT, 0);
+	succeed = succeed && !compiler->outOfMemory;
+
+	if (!succeed) {
+		destroyBytecodeProgram(bytecodeProgram);
+		return NULL;
+	}
+
+	logDebugging(_logger, "Compilation is done (%u statements, %u words, %u constants, %u slots).",
+		bytecodeProgram->statementCount,
+		bytecodeProgram->codeSize,
+		bytecodeProgram->constantCount,
+		bytecodeProgram->slotCount);
+	return bytecodeProgram;
+}
+
+BytecodeCompiler * createBytecodeCompiler(SymbolTable * symbolTable, Interner * interner) {
+	BytecodeCompiler * compiler = malloc(sizeof(BytecodeCompiler));
+	BytecodeProgram * bytecodeProgram = _createBytecodeProgram();
+	if (compiler == NULL || bytecodeProgram == NULL) {
+		logError(_logger, "Cannot allocate the incremental compiler.");
+		free(compiler);
+		destroyBytecodeProgram(bytecodeProgram);
+		return NULL;
+	}
+	_initializeCompiler(compiler, bytecodeProgram, symbolTable, interner);
+	if (compiler->outOfMemory) {
+		destroyBytecodeCompiler(compiler);
+		return NULL;
+	}
+	return compiler;
+}
+
+void destroyBytecodeCompiler(BytecodeCompiler * compiler) {
+	if (compiler == NULL) { return; }
+
+	logDebugging(_logger, "Streamed compilation is done (%u statements, %u words retained, %u constants retained, %u slots).",
+		compiler->bytecodeProgram->statementCount,
+		compiler->retainedCodeSize,
+		compiler->retainedConstantCount,
+		compiler->bytecodeProgram->slotCount);
+	destroyBytecodeProgram(compiler->bytecodeProgram);
+	free(compiler);
+}
+
+BytecodeProgram * getBytecodeProgram(BytecodeCompiler * compiler) {
+	return compiler->bytecodeProgram;
+}
+
+int compileStatement(BytecodeCompiler * compiler, Statement * statement, const ExpressionPool * expressions) {
+	BytecodeProgram * program = compiler->bytecodeProgram;
+	program->codeSize = compiler->retainedCodeSize;
+	program->constantCount = compiler->retainedConstantCount;
+	_destroyFinders(program, compiler->retainedFinderCount);
+	_destroyAutomata(program, compiler->retainedAutomatonCount);
+	compiler->expressions = expressions->expressions;
+	compiler->stackDepth = 0;
+
+	const unsigned int entry = program->codeSize;
+	if (!_reserveSlots(compiler) || !_compileStatement(compiler, statement)) {
+		return -1;
+	}
+	if (statement->type == STATEMENT_ROUTINE) {
+		compiler->retainedCodeSize = program->codeSize;
+		compiler->retainedConstantCount = program->constantCount;
+		compiler->retainedFinderCount = program->finderCount;
+		compiler->retainedAutomatonCount = program->automatonCount;
+	}
+	_emit(compiler, OP_HALT, 0);
+	return compiler->outOfMemory ? -1 : (int) entry;
+}
+
+void destroyBytecodeProgram(BytecodeProgram * bytecodeProgram) {
+	if (bytecodeProgram == NULL) { return; }
+
+	free(bytecodeProgram->constants);
+	free(bytecodeProgram->constantLengths);
+	_destroyFinders(bytecodeProgram, 0);
+	free(bytecodeProgram->finders);
+	_destroyAutomata(bytecodeProgram, 0);
+	free(bytecodeProgram->automata);
+	free(bytecodeProgram->routineEntries);
+	free(bytecodeProgram->slotTypes);
+	free(bytecodeProgram->code);
+	free(bytecodeProgram);
+}
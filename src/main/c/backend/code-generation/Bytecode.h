@@ -0,0 +1,156 @@
+#ifndef BYTECODE_HEADER
+#define BYTECODE_HEADER
+
+#include "../../frontend/syntactic-analysis/AbstractSyntaxTree.h"
+#include "../../shared/Interner.h"
+#include "../../shared/Logger.h"
+#include "../../shared/Type.h"
+#include "../semantic-analysis/SymbolTable.h"
+#include "Builtins.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The instruction set of the virtual machine. Every instruction is a single
+ * 32-bit word, optionally followed by its operands (also 32-bit words).
+ */
+typedef enum {
+	OP_HALT,					// Stops the execution.
+	OP_PUSH_CONSTANT,			// <constant>: pushes a copy of a constant.
+	OP_PUSH_ATOMIC,				// <low> <high>: pushes an atomic value (64 bits).
+	OP_LOAD,					// <slot>: pushes a copy of a variable.
+	OP_LOAD_ATOMIC,				// <slot>: pushes an atomic variable.
+	OP_STORE,					// <slot>: pops the top into a variable.
+	OP_STORE_ATOMIC,			// <slot>: pops the top into an atomic variable.
+	OP_POP,						// Discards the top.
+	OP_POP_ATOMIC,				// Discards the atomic top.
+	OP_TO_STRING,				// Converts the atomic top into a string.
+	OP_TO_ATOMIC,				// Converts the top into an atomic value.
+	OP_ADD,						// Pops two atomic values, and pushes the result.
+	OP_SUBTRACT,
+	OP_MULTIPLY,
+	OP_DIVIDE,
+	OP_CONCATENATE,				// Pops two strings, and pushes their concatenation.
+	OP_REV,
+	OP_TUP,
+	OP_TLO,
+	OP_LEN,
+	OP_RPL,
+	OP_RPL_CONSTANT,			// <finder>: pops a string and a replacement, and replaces a constant target.
+	OP_MRP,						// <count>: pops a string and the pairs of targets and replacements.
+	OP_MRP_CONSTANT,			// <automaton>: pops a string and the replacements of constant targets.
+	OP_ECP,
+	OP_RND,
+	OP_INTERPOLATE,				// <count> <fragment>...: joins constants and variables.
+	OP_OUT,						// Pops the top and sends it to the output.
+	OP_OUT_ATOMIC,				// Pops the atomic top and sends it to the output.
+	OP_WRITE_CONSTANT,			// <constant>: sends a constant to the output.
+	OP_WRITE_SLOT,				// <slot>: sends a variable to the output.
+	OP_WRITE_ATOMIC_SLOT,		// <slot>: sends an atomic variable to the output.
+	OP_CALL,					// <slot>: calls the routine bound to a slot.
+	OP_RETURN,					// Returns from a routine.
+	OP_JUMP,					// <address>: continues at an absolute address.
+	OPCODE_COUNT
+} Opcode;
+
+/**
+ * A fragment operand of OP_INTERPOLATE is the index of a constant, or the
+ * slot of a variable if it has this flag (and of an atomic variable if it
+ * also has the second one).
+ */
+#define FRAGMENT_SLOT_FLAG			0x80000000u
+#define FRAGMENT_ATOMIC_FLAG		0x40000000u
+#define FRAGMENT_OPERAND_MASK		0x3FFFFFFFu
+
+/**
+ * A compiled program: the instruction stream, the constant pool and the
+ * layout of the variable slots.
+ */
+typedef struct {
+	uint32_t * code;
+	unsigned int codeSize;
+	unsigned int codeCapacity;
+
+	// The constants are interned strings (borrowed, not owned).
+	const char ** constants;
+	size_t * constantLengths;
+	unsigned int constantCount;
+	unsigned int constantCapacity;
+
+	// The searches of the constant targets of RPL, prepared during the
+	// compilation (owned).
+	Finder ** finders;
+	unsigned int finderCount;
+	unsigned int finderCapacity;
+
+	// The automata of the constant targets of MRP, built during the
+	// compilation (owned).
+	Automaton ** automata;
+	unsigned int automatonCount;
+	unsigned int automatonCapacity;
+
+	// Entry-point of the routine bound to each slot, or -1 for variables,
+	// and the type of the value of each slot (STRING_TYPE for routines).
+	int * routineEntries;
+	ConstantType * slotTypes;
+	unsigned int slotCount;
+
+	// The maximum depth the operand stack can reach.
+	unsigned int maximumStackDepth;
+
+	// The amount of statements lowered (for statistics).
+	unsigned int statementCount;
+} BytecodeProgram;
+
+/**
+ * An incremental compiler, that lowers the top-level statements of a
+ * streamed program one at a time, into the same program.
+ */
+typedef struct BytecodeCompiler BytecodeCompiler;
+
+/** Initialize module's internal state. */
+void initializeBytecodeModule();
+
+/** Shutdown module's internal state. */
+void shutdownBytecodeModule();
+
+/**
+ * Lowers an analyzed program into bytecode. Every identifier must be already
+ * resolved to its slot, so this phase must run after the semantic analysis.
+ * The constant pool references the strings of the interner, so the program
+ * must not outlive it. Returns NULL on failure.
+ */
+BytecodeProgram * compileProgram(Program * program, SymbolTable * symbolTable, Interner * interner);
+
+/**
+ * Destroy a compiled program and its resources.
+ */
+void destroyBytecodeProgram(BytecodeProgram * bytecodeProgram);
+
+/**
+ * Creates an incremental compiler, with an empty program. The same rules of
+ * "compileProgram" apply to every statement.
+ */
+BytecodeCompiler * createBytecodeCompiler(SymbolTable * symbolTable, Interner * interner);
+
+/**
+ * Destroy an incremental compiler, and its program.
+ */
+void destroyBytecodeCompiler(BytecodeCompiler * compiler);
+
+/**
+ * The program where the statements are compiled. Its buffers may move after
+ * every statement.
+ */
+BytecodeProgram * getBytecodeProgram(BytecodeCompiler * compiler);
+
+/**
+ * Lowers a top-level statement at the end of the program, followed by a
+ * halt, and returns the address of its first instruction (or -1 on failure).
+ * The code and constants of the previous statement are discarded (so it must
+ * have run already), unless it defined a routine.
+ */
+int compileStatement(BytecodeCompiler * compiler, Statement * statement, const ExpressionPool * expressions);
+
+#endif
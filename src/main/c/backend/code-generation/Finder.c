@@ -0,0 +1,164 @@
+#include "Finder.h"
+
+/**
+ * The hash of a pair of bytes, in the bad-character table.
+ */
+#define PAIR_HASH(previous, last)		((unsigned char) ((last) - ((previous) << 3)))
+
+/** PRIVATE FUNCTIONS */
+
+static size_t _maximalSuffix(const unsigned char * needle, const size_t length, const boolean reversed, size_t * period);
+static size_t _findCandidates(const Finder * finder, const char * haystack, const size_t length, size_t from);
+static size_t _findTwoWay(const Finder * finder, const unsigned char * haystack, const size_t length, size_t from);
+
+/**
+ * The start of the maximal suffix of a needle, in the lexicographic order
+ * (or in the reversed one), minus one, and its period.
+ */
+static size_t _maximalSuffix(const unsigned char * needle, const size_t length, const boolean reversed, size_t * period) {
+	size_t suffix = (size_t) -1;
+	size_t candidate = 0;
+	size_t offset = 1;
+	*period = 1;
+	while (candidate + offset < length) {
+		const unsigned char a = needle[suffix + offset];
+		const unsigned char b = needle[candidate + offset];
+		if (a == b) {
+			if (offset == *period) {
+				candidate += *period;
+				offset = 1;
+			}
+			else {
+				++offset;
+			}
+		}
+		else if (reversed ? a < b : b < a) {
+			candidate += offset;
+			offset = 1;
+			*period = candidate - suffix;
+		}
+		else {
+			suffix = candidate++;
+			offset = *period = 1;
+		}
+	}
+	return suffix;
+}
+
+/**
+ * Every candidate costs the length of the needle (at most), so a long one
+ * falls back to Two-Way when they cost more than the scanned bytes.
+ */
+static size_t _findCandidates(const Finder * finder, const char * haystack, const size_t length, size_t from) {
+	const size_t last = finder->length - 1;
+	const size_t gap = last - finder->prefiltered;
+	const size_t end = length - last;
+	const size_t origin = from;
+	size_t verified = 0;
+	while ((from = findPair(haystack + finder->prefiltered, from, end, finder->needle[finder->prefiltered], finder->needle[last], gap)) < end) {
+		if (memcmp(haystack + from, finder->needle, last) == 0) {
+			return from;
+		}
+		++from;
+		verified += last;
+		if (TWO_WAY_NEEDLE_LENGTH <= finder->length && 2 * (from - origin) + TWO_WAY_FALLBACK_BUDGET < verified) {
+			return _findTwoWay(finder, (const unsigned char *) haystack, length, from);
+		}
+	}
+	return NOT_FOUND;
+}
+
+/**
+ * The window is checked by its last pair of bytes first, then the right half of the
+ * needle from the critical position, and the left half last.
+ */
+static size_t _findTwoWay(const Finder * finder, const unsigned char * haystack, const size_t length, size_t from) {
+	const unsigned char * needle = (const unsigned char *) finder->needle;
+	const size_t needleLength = finder->length;
+	size_t memory = 0;
+	while (needleLength <= length - from) {
+		const unsigned char * window = haystack + from;
+		size_t k = finder->shifts[PAIR_HASH(window[needleLength - 2], window[needleLength - 1])];
+		if (k != 0) {
+			// The pair is a lower bound of the next alignment, but it can be
+			// shorter than the remembered prefix, so the prefix is forgotten.
+			from += k;
+			memory = 0;
+			continue;
+		}
+		k = finder->critical < memory ? memory : finder->critical;
+		while (k < needleLength && needle[k] == window[k]) {
+			++k;
+		}
+		if (k < needleLength) {
+			from += k - finder->critical + 1;
+			memory = 0;
+			continue;
+		}
+		k = finder->critical;
+		while (memory < k && needle[k - 1] == window[k - 1]) {
+			--k;
+		}
+		if (k <= memory) {
+			return from;
+		}
+		from += finder->period;
+		memory = finder->memory;
+	}
+	return NOT_FOUND;
+}
+
+/** PUBLIC FUNCTIONS */
+
+void prepareFinder(Finder * finder, const char * needle, const size_t length) {
+	finder->needle = needle;
+	finder->length = length;
+	finder->prefiltered = 0;
+	if (length != 0 && needle[0] == needle[length - 1]) {
+		for (size_t k = length - 1; 0 < k--;) {
+			if (needle[k] != needle[length - 1]) {
+				finder->prefiltered = k;
+				break;
+			}
+		}
+	}
+	if (length < TWO_WAY_NEEDLE_LENGTH) {
+		return;
+	}
+	const unsigned char * bytes = (const unsigned char *) needle;
+	for (size_t k = 0; k < 256; ++k) {
+		finder->shifts[k] = length - 1;
+	}
+	for (size_t k = 1; k < length; ++k) {
+		finder->shifts[PAIR_HASH(bytes[k - 1], bytes[k])] = length - 1 - k;
+	}
+
+	// The critical position comes from the longest of both maximal suffixes.
+	size_t period;
+	size_t reversedPeriod;
+	size_t suffix = _maximalSuffix(bytes, length, false, &period);
+	const size_t reversedSuffix = _maximalSuffix(bytes, length, true, &reversedPeriod);
+	if (suffix + 1 < reversedSuffix + 1) {
+		suffix = reversedSuffix;
+		period = reversedPeriod;
+	}
+	finder->critical = suffix + 1;
+	if (memcmp(bytes, bytes + period, finder->critical) == 0) {
+		finder->period = period;
+		finder->memory = length - period;
+	}
+	else {
+		// The left half is never empty here (an empty one is periodic).
+		const size_t left = finder->critical - 1;
+		const size_t right = length - finder->critical;
+		finder->period = (left < right ? right : left) + 1;
+		finder->memory = 0;
+	}
+}
+
+size_t findNext(const Finder * finder, const char * haystack, const size_t length, const size_t from) {
+	if (finder->length == 0 || length < from || length - from < finder->length) {
+		return NOT_FOUND;
+	}
+	return _findCandidates(finder, haystack, length, from);
+}
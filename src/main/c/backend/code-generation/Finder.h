@@ -0,0 +1,72 @@
+#ifndef FINDER_HEADER
+#define FINDER_HEADER
+
+#include "../../shared/Type.h"
+#include "Kernels.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** The index of a needle that is not found. */
+#define NOT_FOUND					((size_t) -1)
+
+/**
+ * The shortest needle that can fall back to the Two-Way algorithm. The
+ * verification of a shorter one is always cheap.
+ */
+#define TWO_WAY_NEEDLE_LENGTH		32
+
+/**
+ * The bytes that the verifications of the candidates can compare beyond
+ * twice the scanned ones, before the search falls back to Two-Way.
+ */
+#define TWO_WAY_FALLBACK_BUDGET		4096
+
+/**
+ * The precomputed search of a needle (a substring). The candidates come from
+ * a vectorized prefilter of two of its bytes (see "findPair"), and are
+ * verified with "memcmp". When a long needle has too many candidates
+ * (e.g., "aaa...aba" inside "aaa...a"), the search falls back to the Two-Way
+ * algorithm, which never compares a byte of the haystack more than twice,
+ * so it's linear even on pathological inputs. It's combined with a
+ * bad-character table of byte pairs, that skips most of the haystack. The
+ * needle is borrowed, so it must outlive the finder.
+ *
+ * @see https://doi.org/10.1145/116825.116845
+ */
+typedef struct {
+	const char * needle;
+	size_t length;
+
+	// The index of the byte that is prefiltered along with the last one: the
+	// first byte, unless it's the same as the last one (e.g., "aaa...aba").
+	// Then, the last byte that is different, if any.
+	size_t prefiltered;
+
+	// The critical factorization of a long needle: the end of its left half,
+	// its period, and how much of it is already known to match after a
+	// shift by the period (zero if the needle is not periodic).
+	size_t critical;
+	size_t period;
+	size_t memory;
+
+	// The distance from the end of a long needle to the last occurrence of
+	// each pair of bytes, by their hash (or its length minus one, if no pair
+	// with the hash is in it).
+	size_t shifts[256];
+} Finder;
+
+/**
+ * Precomputes the search of a needle, which can be empty (and then it's
+ * never found).
+ */
+void prepareFinder(Finder * finder, const char * needle, const size_t length);
+
+/**
+ * The first index of the needle in a haystack from another index, or
+ * NOT_FOUND.
+ */
+size_t findNext(const Finder * finder, const char * haystack, const size_t length, const size_t from);
+
+#endif
@@ -6,13 +6,46 @@
 #include "../../shared/Logger.h"
 #include "../../shared/String.h"
 #include "../semantic-analysis/SymbolTable.h"
+#include "Bytecode.h"
+#include "VirtualMachine.h"
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
 
 /**
- * Generates the final output using the current compiler state.
+ * A generator of a streamed program, that compiles and runs every top-level
+ * statement as soon as it's parsed.
  */
-void generate(CompilerState* compilerState, SymbolTable* symbolTable);
+typedef struct StreamGenerator StreamGenerator;
+
+/** Initialize module's internal state. */
+void initializeGeneratorModule();
+
+/** Shutdown module's internal state. */
+void shutdownGeneratorModule();
+
+/**
+ * Generates the final output using the compiler state, into its output
+ * stream. Returns false if the program could not be compiled or its
+ * execution failed.
+ */
+boolean generate(CompilerState* compilerState, SymbolTable* symbolTable);
+
+/**
+ * Creates a generator for a streamed program, into the output stream of the
+ * compiler state. Returns NULL if the system runs out of memory.
+ */
+StreamGenerator* createStreamGenerator(CompilerState* compilerState, SymbolTable* symbolTable);
+
+/**
+ * Compiles and runs a top-level statement (already analyzed). Returns false
+ * if it could not be compiled or its execution failed.
+ */
+boolean generateStatement(StreamGenerator* generator, Statement* statement);
+
+/**
+ * Sends the pending output, and destroys the generator.
+ */
+void destroyStreamGenerator(StreamGenerator* generator);
 
 #endif
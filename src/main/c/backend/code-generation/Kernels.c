@@ -0,0 +1,559 @@
+#include "Kernels.h"
+
+/**
+ * The letters of a case are a range of 26 bytes, and the same letter of the
+ * other case only differs in a single bit.
+ */
+#define LETTER_COUNT		26
+#define CASE_BIT			0x20
+
+/**
+ * The longest UTF-8 sequence has a leading byte and 3 continuation bytes
+ * (with the bits 10xxxxxx). The leading ones have the bits 11xxxxxx, and
+ * their high bits tell the amount of continuation bytes that follow: 110xxxxx
+ * has 1, 1110xxxx has 2, and 11110xxx has 3 (the longer ones are invalid).
+ */
+#define IS_CONTINUATION_BYTE(byte)		(((unsigned char) (byte) & 0xC0) == 0x80)
+#define IS_LEADING_BYTE(byte)			(((unsigned char) (byte) & 0xC0) == 0xC0)
+#define CONTINUATION_BYTES(byte)		((unsigned char) (byte) < 0xE0 ? 1 : (unsigned char) (byte) < 0xF0 ? 2 : (unsigned char) (byte) < 0xF8 ? 3 : 0)
+
+/**
+ * The kernels of an instruction set.
+ */
+typedef struct {
+	// Flips the case of the letters in the range that starts with "first"
+	// ('a' or 'A'), in place.
+	void (*convertCase)(char * characters, const size_t length, const char first);
+
+	// Reverses the bytes, in place.
+	void (*reverse)(char * characters, const size_t length);
+
+	// Reverses the bytes of a source into a destiny (they don't overlap).
+	void (*reverseInto)(char * destiny, const char * source, const size_t length);
+
+	// The index of the first non-ASCII byte from another index (or the
+	// length, if there is none).
+	size_t (*skipAscii)(const char * characters, size_t from, const size_t length);
+
+	// The first index from another one (but before an end) where a byte is
+	// "first", and the one at a distance "gap" is "last" (or the end, if
+	// there is none).
+	size_t (*findPair)(const char * characters, size_t from, const size_t end, const char first, const char last, const size_t gap);
+
+	// The first index from another one (but before an end) where a byte is
+	// any of three (or the end, if there is none).
+	size_t (*findAny)(const char * characters, size_t from, const size_t end, const char first, const char second, const char third);
+} KernelTable;
+
+/** PRIVATE FUNCTIONS */
+
+static void _convertCaseScalar(char * characters, const size_t length, const char first);
+static void _reverseScalar(char * characters, const size_t length);
+static void _reverseIntoScalar(char * destiny, const char * source, const size_t length);
+static size_t _skipAsciiScalar(const char * characters, size_t from, const size_t length);
+static size_t _findPairScalar(const char * characters, size_t from, const size_t end, const char first, const char last, const size_t gap);
+static size_t _findAnyScalar(const char * characters, size_t from, const size_t end, const char first, const char second, const char third);
+#ifdef X86_KERNELS
+static void _convertCaseSse2(char * characters, const size_t length, const char first);
+static void _reverseSse2(char * characters, const size_t length);
+static void _reverseIntoSse2(char * destiny, const char * source, const size_t length);
+static size_t _skipAsciiSse2(const char * characters, size_t from, const size_t length);
+static size_t _findPairSse2(const char * characters, size_t from, const size_t end, const char first, const char last, const size_t gap);
+static size_t _findAnySse2(const char * characters, size_t from, const size_t end, const char first, const char second, const char third);
+static void _convertCaseAvx2(char * characters, const size_t length, const char first);
+static void _reverseAvx2(char * characters, const size_t length);
+static void _reverseIntoAvx2(char * destiny, const char * source, const size_t length);
+static size_t _skipAsciiAvx2(const char * characters, size_t from, const size_t length);
+static size_t _findPairAvx2(const char * characters, size_t from, const size_t end, const char first, const char last, const size_t gap);
+static size_t _findAnyAvx2(const char * characters, size_t from, const size_t end, const char first, const char second, const char third);
+static void _convertCaseAvx512(char * characters, const size_t length, const char first);
+static void _reverseAvx512(char * characters, const size_t length);
+static void _reverseIntoAvx512(char * destiny, const char * source, const size_t length);
+static size_t _skipAsciiAvx512(const char * characters, size_t from, const size_t length);
+static size_t _findPairAvx512(const char * characters, size_t from, const size_t end, const char first, const char last, const size_t gap);
+static size_t _findAnyAvx512(const char * characters, size_t from, const size_t end, const char first, const char second, const char third);
+#endif
+static InstructionSet _detectInstructionSet();
+static InstructionSet _instructionSetFromString(const char * instructionSet);
+static const char * _instructionSetToString(const InstructionSet instructionSet);
+
+/* MODULE INTERNAL STATE */
+
+static const KernelTable _kernelTables[] = {
+	[SCALAR_INSTRUCTION_SET] = { _convertCaseScalar, _reverseScalar, _reverseIntoScalar, _skipAsciiScalar, _findPairScalar, _findAnyScalar },
+#ifdef X86_KERNELS
+	[SSE2_INSTRUCTION_SET] = { _convertCaseSse2, _reverseSse2, _reverseIntoSse2, _skipAsciiSse2, _findPairSse2, _findAnySse2 },
+	[AVX2_INSTRUCTION_SET] = { _convertCaseAvx2, _reverseAvx2, _reverseIntoAvx2, _skipAsciiAvx2, _findPairAvx2, _findAnyAvx2 },
+	[AVX512_INSTRUCTION_SET] = { _convertCaseAvx512, _reverseAvx512, _reverseIntoAvx512, _skipAsciiAvx512, _findPairAvx512, _findAnyAvx512 }
+#endif
+};
+
+static Logger * _logger = NULL;
+static InstructionSet _instructionSet = SCALAR_INSTRUCTION_SET;
+static const KernelTable * _kernels = &_kernelTables[SCALAR_INSTRUCTION_SET];
+
+/**
+ * A byte is in the range if its distance to the first letter (unsigned) is
+ * short enough.
+ */
+static void _convertCaseScalar(char * characters, const size_t length, const char first) {
+	for (size_t k = 0; k < length; ++k) {
+		characters[k] ^= (unsigned char) (characters[k] - first) < LETTER_COUNT ? CASE_BIT : 0;
+	}
+}
+
+static void _reverseScalar(char * characters, const size_t length) {
+	for (size_t front = 0, back = length; 1 < back - front; ++front) {
+		const char character = characters[front];
+		characters[front] = characters[--back];
+		characters[back] = character;
+	}
+}
+
+static void _reverseIntoScalar(char * destiny, const char * source, const size_t length) {
+	for (size_t k = 0; k < length; ++k) {
+		destiny[k] = source[length - 1 - k];
+	}
+}
+
+/**
+ * Checks a word at a time while it's possible.
+ */
+static size_t _skipAsciiScalar(const char * characters, size_t from, const size_t length) {
+	for (; from + sizeof(uint64_t) <= length; from += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, characters + from, sizeof(word));
+		if (word & 0x8080808080808080ull) {
+			break;
+		}
+	}
+	while (from < length && (unsigned char) characters[from] < 0x80) {
+		++from;
+	}
+	return from;
+}
+
+static size_t _findPairScalar(const char * characters, size_t from, const size_t end, const char first, const char last, const size_t gap) {
+	while (from < end && (characters[from] != first || characters[from + gap] != last)) {
+		++from;
+	}
+	return from;
+}
+
+static size_t _findAnyScalar(const char * characters, size_t from, const size_t end, const char first, const char second, const char third) {
+	while (from < end && characters[from] != first && characters[from] != second && characters[from] != third) {
+		++from;
+	}
+	return from;
+}
+
+#ifdef X86_KERNELS
+/**
+ * There are only signed comparisons of bytes, so the range is moved to the
+ * bottom of the signed ones (from -128), where a single comparison finds it.
+ * The tail is left to the scalar kernel.
+ */
+__attribute__((target("sse2")))
+static void _convertCaseSse2(char * characters, const size_t length, const char first) {
+	const __m128i shift = _mm_set1_epi8((char) (0x80 - first));
+	const __m128i limit = _mm_set1_epi8((char) (-128 + LETTER_COUNT));
+	const __m128i flip = _mm_set1_epi8(CASE_BIT);
+	size_t k = 0;
+	for (; k + sizeof(__m128i) <= length; k += sizeof(__m128i)) {
+		const __m128i bytes = _mm_loadu_si128((const __m128i *) (characters + k));
+		const __m128i letters = _mm_cmplt_epi8(_mm_add_epi8(bytes, shift), limit);
+		_mm_storeu_si128((__m128i *) (characters + k), _mm_xor_si128(bytes, _mm_and_si128(letters, flip)));
+	}
+	_convertCaseScalar(characters + k, length - k, first);
+}
+
+/**
+ * SSE2 has no byte shuffle, so the words are reversed first, then their
+ * halves, and then the bytes of each half.
+ */
+__attribute__((target("sse2")))
+static inline __m128i _reverseBlockSse2(__m128i bytes) {
+	bytes = _mm_shuffle_epi32(bytes, _MM_SHUFFLE(0, 1, 2, 3));
+	bytes = _mm_shufflelo_epi16(bytes, _MM_SHUFFLE(2, 3, 0, 1));
+	bytes = _mm_shufflehi_epi16(bytes, _MM_SHUFFLE(2, 3, 0, 1));
+	return _mm_or_si128(_mm_slli_epi16(bytes, 8), _mm_srli_epi16(bytes, 8));
+}
+
+/**
+ * A block from each end is reversed, and they are swapped, until the middle
+ * is shorter than two blocks.
+ */
+__attribute__((target("sse2")))
+static void _reverseSse2(char * characters, const size_t length) {
+	size_t front = 0;
+	size_t back = length;
+	for (; 2 * sizeof(__m128i) <= back - front; front += sizeof(__m128i), back -= sizeof(__m128i)) {
+		const __m128i head = _mm_loadu_si128((const __m128i *) (characters + front));
+		const __m128i tail = _mm_loadu_si128((const __m128i *) (characters + back - sizeof(__m128i)));
+		_mm_storeu_si128((__m128i *) (characters + front), _reverseBlockSse2(tail));
+		_mm_storeu_si128((__m128i *) (characters + back - sizeof(__m128i)), _reverseBlockSse2(head));
+	}
+	_reverseScalar(characters + front, back - front);
+}
+
+__attribute__((target("sse2")))
+static void _reverseIntoSse2(char * destiny, const char * source, const size_t length) {
+	size_t k = 0;
+	for (; k + sizeof(__m128i) <= length; k += sizeof(__m128i)) {
+		const __m128i bytes = _mm_loadu_si128((const __m128i *) (source + length - k - sizeof(__m128i)));
+		_mm_storeu_si128((__m128i *) (destiny + k), _reverseBlockSse2(bytes));
+	}
+	_reverseIntoScalar(destiny + k, source, length - k);
+}
+
+__attribute__((target("sse2")))
+static size_t _skipAsciiSse2(const char * characters, size_t from, const size_t length) {
+	for (; from + sizeof(__m128i) <= length; from += sizeof(__m128i)) {
+		const int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) (characters + from)));
+		if (mask != 0) {
+			return from + __builtin_ctz(mask);
+		}
+	}
+	return _skipAsciiScalar(characters, from, length);
+}
+
+/**
+ * Compares a block at every index, and the one at the gap, so only the
+ * candidates where both bytes match are returned.
+ */
+__attribute__((target("sse2")))
+static size_t _findPairSse2(const char * characters, size_t from, const size_t end, const char first, const char last, const size_t gap) {
+	const __m128i firsts = _mm_set1_epi8(first);
+	const __m128i lasts = _mm_set1_epi8(last);
+	for (; from + sizeof(__m128i) <= end; from += sizeof(__m128i)) {
+		const __m128i heads = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (characters + from)), firsts);
+		const __m128i tails = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (characters + from + gap)), lasts);
+		const int mask = _mm_movemask_epi8(_mm_and_si128(heads, tails));
+		if (mask != 0) {
+			return from + __builtin_ctz(mask);
+		}
+	}
+	return _findPairScalar(characters, from, end, first, last, gap);
+}
+
+__attribute__((target("sse2")))
+static size_t _findAnySse2(const char * characters, size_t from, const size_t end, const char first, const char second, const char third) {
+	const __m128i firsts = _mm_set1_epi8(first);
+	const __m128i seconds = _mm_set1_epi8(second);
+	const __m128i thirds = _mm_set1_epi8(third);
+	for (; from + sizeof(__m128i) <= end; from += sizeof(__m128i)) {
+		const __m128i bytes = _mm_loadu_si128((const __m128i *) (characters + from));
+		const __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(bytes, firsts),
+			_mm_or_si128(_mm_cmpeq_epi8(bytes, seconds), _mm_cmpeq_epi8(bytes, thirds)));
+		const int mask = _mm_movemask_epi8(matches);
+		if (mask != 0) {
+			return from + __builtin_ctz(mask);
+		}
+	}
+	return _findAnyScalar(characters, from, end, first, second, third);
+}
+
+__attribute__((target("avx2")))
+static void _convertCaseAvx2(char * characters, const size_t length, const char first) {
+	const __m256i shift = _mm256_set1_epi8((char) (0x80 - first));
+	const __m256i limit = _mm256_set1_epi8((char) (-128 + LETTER_COUNT));
+	const __m256i flip = _mm256_set1_epi8(CASE_BIT);
+	size_t k = 0;
+	for (; k + sizeof(__m256i) <= length; k += sizeof(__m256i)) {
+		const __m256i bytes = _mm256_loadu_si256((const __m256i *) (characters + k));
+		const __m256i letters = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(bytes, shift));
+		_mm256_storeu_si256((__m256i *) (characters + k), _mm256_xor_si256(bytes, _mm256_and_si256(letters, flip)));
+	}
+	_convertCaseSse2(characters + k, length - k, first);
+}
+
+/**
+ * The byte shuffle ("vpshufb") only works inside each half, so the halves
+ * are swapped afterwards.
+ */
+__attribute__((target("avx2")))
+static inline __m256i _reverseBlockAvx2(const __m256i bytes) {
+	const __m256i order = _mm256_setr_epi8(
+		15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+		15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	const __m256i shuffled = _mm256_shuffle_epi8(bytes, order);
+	return _mm256_permute2x128_si256(shuffled, shuffled, 0x01);
+}
+
+__attribute__((target("avx2")))
+static void _reverseAvx2(char * characters, const size_t length) {
+	size_t front = 0;
+	size_t back = length;
+	for (; 2 * sizeof(__m256i) <= back - front; front += sizeof(__m256i), back -= sizeof(__m256i)) {
+		const __m256i head = _mm256_loadu_si256((const __m256i *) (characters + front));
+		const __m256i tail = _mm256_loadu_si256((const __m256i *) (characters + back - sizeof(__m256i)));
+		_mm256_storeu_si256((__m256i *) (characters + front), _reverseBlockAvx2(tail));
+		_mm256_storeu_si256((__m256i *) (characters + back - sizeof(__m256i)), _reverseBlockAvx2(head));
+	}
+	_reverseSse2(characters + front, back - front);
+}
+
+__attribute__((target("avx2")))
+static void _reverseIntoAvx2(char * destiny, const char * source, const size_t length) {
+	size_t k = 0;
+	for (; k + sizeof(__m256i) <= length; k += sizeof(__m256i)) {
+		const __m256i bytes = _mm256_loadu_si256((const __m256i *) (source + length - k - sizeof(__m256i)));
+		_mm256_storeu_si256((__m256i *) (destiny + k), _reverseBlockAvx2(bytes));
+	}
+	_reverseIntoSse2(destiny + k, source, length - k);
+}
+
+__attribute__((target("avx2")))
+static size_t _skipAsciiAvx2(const char * characters, size_t from, const size_t length) {
+	for (; from + sizeof(__m256i) <= length; from += sizeof(__m256i)) {
+		const unsigned int mask = _mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *) (characters + from)));
+		if (mask != 0) {
+			return from + __builtin_ctz(mask);
+		}
+	}
+	return _skipAsciiSse2(characters, from, length);
+}
+
+__attribute__((target("avx2")))
+static size_t _findPairAvx2(const char * characters, size_t from, const size_t end, const char first, const char last, const size_t gap) {
+	const __m256i firsts = _mm256_set1_epi8(first);
+	const __m256i lasts = _mm256_set1_epi8(last);
+	for (; from + sizeof(__m256i) <= end; from += sizeof(__m256i)) {
+		const __m256i heads = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (characters + from)), firsts);
+		const __m256i tails = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (characters + from + gap)), lasts);
+		const unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(heads, tails));
+		if (mask != 0) {
+			return from + __builtin_ctz(mask);
+		}
+	}
+	return _findPairSse2(characters, from, end, first, last, gap);
+}
+
+__attribute__((target("avx2")))
+static size_t _findAnyAvx2(const char * characters, size_t from, const size_t end, const char first, const char second, const char third) {
+	const __m256i firsts = _mm256_set1_epi8(first);
+	const __m256i seconds = _mm256_set1_epi8(second);
+	const __m256i thirds = _mm256_set1_epi8(third);
+	for (; from + sizeof(__m256i) <= end; from += sizeof(__m256i)) {
+		const __m256i bytes = _mm256_loadu_si256((const __m256i *) (characters + from));
+		const __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, firsts),
+			_mm256_or_si256(_mm256_cmpeq_epi8(bytes, seconds), _mm256_cmpeq_epi8(bytes, thirds)));
+		const unsigned int mask = _mm256_movemask_epi8(matches);
+		if (mask != 0) {
+			return from + __builtin_ctz(mask);
+		}
+	}
+	return _findAnySse2(characters, from, end, first, second, third);
+}
+
+/**
+ * The comparisons give a mask of bits, and the tail is handled with masked
+ * loads and stores, so no byte out of the string is ever touched.
+ */
+__attribute__((target("avx512f,avx512bw")))
+static void _convertCaseAvx512(char * characters, const size_t length, const char first) {
+	const __m512i shift = _mm512_set1_epi8((char) (0x80 - first));
+	const __m512i limit = _mm512_set1_epi8((char) (-128 + LETTER_COUNT));
+	const __m512i flip = _mm512_set1_epi8(CASE_BIT);
+	size_t k = 0;
+	for (; k + sizeof(__m512i) <= length; k += sizeof(__m512i)) {
+		const __m512i bytes = _mm512_loadu_si512((const void *) (characters + k));
+		const __mmask64 letters = _mm512_cmplt_epi8_mask(_mm512_add_epi8(bytes, shift), limit);
+		_mm512_storeu_si512((void *) (characters + k), _mm512_xor_si512(bytes, _mm512_maskz_mov_epi8(letters, flip)));
+	}
+	if (k < length) {
+		const __mmask64 tail = (1ull << (length - k)) - 1;
+		const __m512i bytes = _mm512_maskz_loadu_epi8(tail, characters + k);
+		const __mmask64 letters = _mm512_cmplt_epi8_mask(_mm512_add_epi8(bytes, shift), limit);
+		_mm512_mask_storeu_epi8(characters + k, tail, _mm512_xor_si512(bytes, _mm512_maskz_mov_epi8(letters, flip)));
+	}
+}
+
+/**
+ * Like in AVX2, the bytes are shuffled inside every quarter, and then the
+ * quarters are reversed (a permutation of 64-bit words), since "vpermb"
+ * needs the VBMI extension.
+ */
+__attribute__((target("avx512f,avx512bw")))
+static inline __m512i _reverseBlockAvx512(const __m512i bytes) {
+	const __m512i order = _mm512_broadcast_i32x4(_mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+	const __m512i quarters = _mm512_setr_epi64(6, 7, 4, 5, 2, 3, 0, 1);
+	return _mm512_permutexvar_epi64(quarters, _mm512_shuffle_epi8(bytes, order));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void _reverseAvx512(char * characters, const size_t length) {
+	size_t front = 0;
+	size_t back = length;
+	for (; 2 * sizeof(__m512i) <= back - front; front += sizeof(__m512i), back -= sizeof(__m512i)) {
+		const __m512i head = _mm512_loadu_si512((const void *) (characters + front));
+		const __m512i tail = _mm512_loadu_si512((const void *) (characters + back - sizeof(__m512i)));
+		_mm512_storeu_si512((void *) (characters + front), _reverseBlockAvx512(tail));
+		_mm512_storeu_si512((void *) (characters + back - sizeof(__m512i)), _reverseBlockAvx512(head));
+	}
+	_reverseAvx2(characters + front, back - front);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void _reverseIntoAvx512(char * destiny, const char * source, const size_t length) {
+	size_t k = 0;
+	for (; k + sizeof(__m512i) <= length; k += sizeof(__m512i)) {
+		const __m512i bytes = _mm512_loadu_si512((const void *) (source + length - k - sizeof(__m512i)));
+		_mm512_storeu_si512((void *) (destiny + k), _reverseBlockAvx512(bytes));
+	}
+	_reverseIntoAvx2(destiny + k, source, length - k);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t _skipAsciiAvx512(const char * characters, size_t from, const size_t length) {
+	for (; from + sizeof(__m512i) <= length; from += sizeof(__m512i)) {
+		const __mmask64 mask = _mm512_movepi8_mask(_mm512_loadu_si512((const void *) (characters + from)));
+		if (mask != 0) {
+			return from + __builtin_ctzll(mask);
+		}
+	}
+	return _skipAsciiAvx2(characters, from, length);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t _findPairAvx512(const char * characters, size_t from, const size_t end, const char first, const char last, const size_t gap) {
+	const __m512i firsts = _mm512_set1_epi8(first);
+	const __m512i lasts = _mm512_set1_epi8(last);
+	for (; from + sizeof(__m512i) <= end; from += sizeof(__m512i)) {
+		const __mmask64 heads = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void *) (characters + from)), firsts);
+		const __mmask64 mask = _mm512_mask_cmpeq_epi8_mask(heads, _mm512_loadu_si512((const void *) (characters + from + gap)), lasts);
+		if (mask != 0) {
+			return from + __builtin_ctzll(mask);
+		}
+	}
+	return _findPairAvx2(characters, from, end, first, last, gap);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t _findAnyAvx512(const char * characters, size_t from, const size_t end, const char first, const char second, const char third) {
+	const __m512i firsts = _mm512_set1_epi8(first);
+	const __m512i seconds = _mm512_set1_epi8(second);
+	const __m512i thirds = _mm512_set1_epi8(third);
+	for (; from + sizeof(__m512i) <= end; from += sizeof(__m512i)) {
+		const __m512i bytes = _mm512_loadu_si512((const void *) (characters + from));
+		const __mmask64 mask = _mm512_cmpeq_epi8_mask(bytes, firsts)
+			| _mm512_cmpeq_epi8_mask(bytes, seconds) | _mm512_cmpeq_epi8_mask(bytes, thirds);
+		if (mask != 0) {
+			return from + __builtin_ctzll(mask);
+		}
+	}
+	return _findAnyAvx2(characters, from, end, first, second, third);
+}
+#endif
+
+/**
+ * The best instruction set that both the processor and the operating system
+ * support.
+ */
+static InstructionSet _detectInstructionSet() {
+#ifdef X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+		return AVX512_INSTRUCTION_SET;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		return AVX2_INSTRUCTION_SET;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return SSE2_INSTRUCTION_SET;
+	}
+#endif
+	return SCALAR_INSTRUCTION_SET;
+}
+
+static InstructionSet _instructionSetFromString(const char * instructionSet) {
+	if (strcmp(instructionSet, "SSE2") == 0) return SSE2_INSTRUCTION_SET;
+	else if (strcmp(instructionSet, "AVX2") == 0) return AVX2_INSTRUCTION_SET;
+	else if (strcmp(instructionSet, "AVX512") == 0) return AVX512_INSTRUCTION_SET;
+	else return SCALAR_INSTRUCTION_SET;
+}
+
+static const char * _instructionSetToString(const InstructionSet instructionSet) {
+	switch (instructionSet) {
+		case SSE2_INSTRUCTION_SET: return "SSE2";
+		case AVX2_INSTRUCTION_SET: return "AVX2";
+		case AVX512_INSTRUCTION_SET: return "AVX512";
+		default: return "SCALAR";
+	}
+}
+
+/** PUBLIC FUNCTIONS */
+
+void initializeKernelsModule() {
+	_logger = createLogger("Kernels");
+	const InstructionSet detected = _detectInstructionSet();
+	const char * forced = getStringOrDefault("INSTRUCTION_SET", NULL);
+
+	_instructionSet = forced == NULL ? detected : _instructionSetFromString(forced);
+	if (detected < _instructionSet) {
+		logWarning(_logger, "The instruction set %s is not supported (falling back to %s).",
+			_instructionSetToString(_instructionSet), _instructionSetToString(detected));
+		_instructionSet = detected;
+	}
+	_kernels = &_kernelTables[_instructionSet];
+	logDebugging(_logger, "Using the %s kernels.", _instructionSetToString(_instructionSet));
+}
+
+void shutdownKernelsModule() {
+	if (_logger != NULL) {
+		destroyLogger(_logger);
+	}
+}
+
+InstructionSet getInstructionSet() {
+	return _instructionSet;
+}
+
+void upperCase(char * characters, const size_t length) {
+	_kernels->convertCase(characters, length, 'a');
+}
+
+void lowerCase(char * characters, const size_t length) {
+	_kernels->convertCase(characters, length, 'A');
+}
+
+void reverse(char * characters, const size_t length) {
+	_kernels->reverse(characters, length);
+}
+
+void reverseInto(char * destiny, const char * source, const size_t length) {
+	_kernels->reverseInto(destiny, source, length);
+}
+
+size_t findPair(const char * characters, const size_t from, const size_t end, const char first, const char last, const size_t gap) {
+	return _kernels->findPair(characters, from, end, first, last, gap);
+}
+
+size_t findAny(const char * characters, const size_t from, const size_t end, const char first, const char second, const char third) {
+	return _kernels->findAny(characters, from, end, first, second, third);
+}
+
+/**
+ * After a reversal, the continuation bytes of a sequence come first, and
+ * its leading byte last. A leading byte only takes as many continuation
+ * bytes as its length says, the closest ones: the stray bytes before them,
+ * and the sequences that are too short, are invalid UTF-8, and stay as they
+ * are. The ASCII runs are skipped by the kernels, a block at a time.
+ */
+void restoreCodePoints(char * characters, const size_t length) {
+	size_t k = _kernels->skipAscii(characters, 0, length);
+	while (k < length) {
+		size_t end = k;
+		while (end < length && IS_CONTINUATION_BYTE(characters[end])) {
+			++end;
+		}
+		if (end < length && IS_LEADING_BYTE(characters[end])) {
+			const size_t continuationBytes = CONTINUATION_BYTES(characters[end]);
+			if (continuationBytes <= end - k) {
+				_reverseScalar(characters + end - continuationBytes, continuationBytes + 1);
+			}
+			++end;
+		}
+		k = _kernels->skipAscii(characters, end, length);
+	}
+}
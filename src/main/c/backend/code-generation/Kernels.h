@@ -0,0 +1,92 @@
+#ifndef KERNELS_HEADER
+#define KERNELS_HEADER
+
+#include "../../shared/Environment.h"
+#include "../../shared/Logger.h"
+#include "../../shared/Type.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * The x86 processors get vectorized kernels (SSE2 is always available there,
+ * and AVX2 or AVX-512 are detected at runtime), with GCC or Clang. Everything
+ * else falls back to the portable ones.
+ *
+ * @see https://gcc.gnu.org/onlinedocs/gcc/x86-Built-in-Functions.html
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/**
+ * The instruction sets of the kernels, from the slowest to the fastest.
+ */
+typedef enum {
+	SCALAR_INSTRUCTION_SET,
+	SSE2_INSTRUCTION_SET,
+	AVX2_INSTRUCTION_SET,
+	AVX512_INSTRUCTION_SET
+} InstructionSet;
+
+/**
+ * Initialize module's internal state: chooses the best instruction set of
+ * the processor, unless another one is forced (see "INSTRUCTION_SET").
+ */
+void initializeKernelsModule();
+
+/** Shutdown module's internal state. */
+void shutdownKernelsModule();
+
+/**
+ * The instruction set used by the kernels.
+ */
+InstructionSet getInstructionSet();
+
+/**
+ * Turns the lowercase ASCII letters into uppercase, in place. The other
+ * bytes are left untouched, like "toupper" does in the "C" locale.
+ */
+void upperCase(char * characters, const size_t length);
+
+/**
+ * Turns the uppercase ASCII letters into lowercase, in place. The other
+ * bytes are left untouched, like "tolower" does in the "C" locale.
+ */
+void lowerCase(char * characters, const size_t length);
+
+/**
+ * Reverses the bytes, in place, swapping blocks from both ends.
+ */
+void reverse(char * characters, const size_t length);
+
+/**
+ * Writes the bytes of a source in reverse order into a destiny, which must
+ * not overlap with it.
+ */
+void reverseInto(char * destiny, const char * source, const size_t length);
+
+/**
+ * Restores the order of the bytes inside every UTF-8 sequence of a reversed
+ * string, so its code points (and not its bytes) end up reversed. The bytes
+ * that are not part of a valid sequence are left as they are.
+ */
+void restoreCodePoints(char * characters, const size_t length);
+
+/**
+ * The first index between "from" and "end" (excluded) where the byte is
+ * "first", and the byte at a distance "gap" is "last", or "end" if there is
+ * none. The bytes before "end + gap" must be readable. It's the prefilter of
+ * a substring search: the candidates must still be verified.
+ */
+size_t findPair(const char * characters, const size_t from, const size_t end, const char first, const char last, const size_t gap);
+
+/**
+ * The first index between "from" and "end" (excluded) where the byte is any
+ * of three (they can be repeated, to look for fewer), or "end" if there is
+ * none. It's the prefilter of a search of many targets, by their first bytes.
+ */
+size_t findAny(const char * characters, const size_t from, const size_t end, const char first, const char second, const char third);
+
+#endif
@@ -0,0 +1,217 @@
+#include "Output.h"
+
+#define OUTPUT_BUFFER_SIZE				(1024 * 1024)
+#define OUTPUT_CHUNK_COUNT				1024
+#define DEFAULT_FLUSH_BYTES				(64 * 1024)
+
+#ifndef VECTORED_OUTPUT
+struct iovec {
+	void * iov_base;
+	size_t iov_len;
+};
+#endif
+
+/**
+ * The copied chunks are stored in the buffer, but every chunk (copied or
+ * referenced) gets its own entry in the vector, in order.
+ */
+struct Output {
+	FILE * stream;
+	FlushPolicy flushPolicy;
+	char * buffer;
+	size_t used;
+	struct iovec chunks[OUTPUT_CHUNK_COUNT];
+	unsigned int chunkCount;
+	size_t pending;
+	boolean flushed;
+	boolean failed;
+};
+
+/* MODULE INTERNAL STATE */
+
+static Logger * _logger = NULL;
+static const char * _flushPolicyName = NULL;
+static size_t _flushBytes = DEFAULT_FLUSH_BYTES;
+
+/* PRIVATE FUNCTIONS */
+
+static void _append(Output * output, const char * chunk, const size_t length);
+static void _applyFlushPolicy(Output * output, const char * chunk, const size_t length);
+static FlushPolicy _flushPolicyFromString(const char * flushPolicy, FILE * stream);
+
+/**
+ * Adds a new entry to the vector, flushing first if it's full.
+ */
+static void _append(Output * output, const char * chunk, const size_t length) {
+	if (output->chunkCount == OUTPUT_CHUNK_COUNT) {
+		flushOutput(output);
+	}
+	output->chunks[output->chunkCount].iov_base = (void *) chunk;
+	output->chunks[output->chunkCount].iov_len = length;
+	++output->chunkCount;
+	output->pending += length;
+}
+
+static void _applyFlushPolicy(Output * output, const char * chunk, const size_t length) {
+	switch (output->flushPolicy) {
+		case FLUSH_PER_BYTES:
+			if (_flushBytes <= output->pending) {
+				flushOutput(output);
+			}
+			break;
+		case FLUSH_PER_LINE:
+			if (memchr(chunk, '\n', length) != NULL) {
+				flushOutput(output);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * Gets the flush policy from the specified string. Terminals are flushed per
+ * line by default, and everything else only when needed.
+ */
+static FlushPolicy _flushPolicyFromString(const char * flushPolicy, FILE * stream) {
+	if (flushPolicy == NULL) {
+#ifdef VECTORED_OUTPUT
+		return isatty(fileno(stream)) ? FLUSH_PER_LINE : FLUSH_ON_EXIT;
+#else
+		return FLUSH_PER_LINE;
+#endif
+	}
+	else if (strcmp(flushPolicy, "BYTES") == 0) return FLUSH_PER_BYTES;
+	else if (strcmp(flushPolicy, "LINE") == 0) return FLUSH_PER_LINE;
+	else return FLUSH_ON_EXIT;
+}
+
+/* PUBLIC FUNCTIONS */
+
+void initializeOutputModule() {
+	_logger = createLogger("Output");
+	_flushPolicyName = getStringOrDefault("OUTPUT_FLUSH_POLICY", NULL);
+	_flushBytes = getIntegerOrDefault("OUTPUT_FLUSH_BYTES", DEFAULT_FLUSH_BYTES);
+}
+
+void shutdownOutputModule() {
+	if (_logger != NULL) {
+		destroyLogger(_logger);
+	}
+}
+
+Output * createOutput(FILE * stream) {
+	Output * output = calloc(1, sizeof(Output));
+	if (output == NULL) {
+		return NULL;
+	}
+	output->buffer = malloc(OUTPUT_BUFFER_SIZE);
+	if (output->buffer == NULL) {
+		free(output);
+		return NULL;
+	}
+	output->stream = stream;
+	output->flushPolicy = _flushPolicyFromString(_flushPolicyName, stream);
+	return output;
+}
+
+void destroyOutput(Output * output) {
+	if (output != NULL) {
+		flushOutput(output);
+		free(output->buffer);
+		free(output);
+	}
+}
+
+void writeOutput(Output * output, const char * chunk, const size_t length) {
+	if (length == 0) {
+		return;
+	}
+	if (OUTPUT_BUFFER_SIZE - output->used < length) {
+		flushOutput(output);
+	}
+	if (OUTPUT_BUFFER_SIZE < length) {
+		// It doesn't fit in the buffer, but it's valid until this call returns.
+		_append(output, chunk, length);
+		flushOutput(output);
+		return;
+	}
+	if (output->chunkCount == OUTPUT_CHUNK_COUNT) {
+		flushOutput(output);
+	}
+
+	char * destiny = output->buffer + output->used;
+	memcpy(destiny, chunk, length);
+	output->used += length;
+
+	struct iovec * last = output->chunkCount == 0 ? NULL : &output->chunks[output->chunkCount - 1];
+	if (last != NULL && (char *) last->iov_base + last->iov_len == destiny) {
+		last->iov_len += length;
+		output->pending += length;
+	}
+	else {
+		_append(output, destiny, length);
+	}
+	_applyFlushPolicy(output, chunk, length);
+}
+
+void referenceOutput(Output * output, const char * chunk, const size_t length) {
+	if (length == 0) {
+		return;
+	}
+	_append(output, chunk, length);
+	_applyFlushPolicy(output, chunk, length);
+}
+
+void flushOutputAtBoundary(Output * output) {
+	if (!output->flushed || _flushBytes <= output->pending) {
+		flushOutput(output);
+	}
+}
+
+void flushOutput(Output * output) {
+	if (output->chunkCount == 0) {
+		return;
+	}
+	// The logs can share the stream, and they must keep their order.
+	fflush(output->stream);
+
+#ifdef VECTORED_OUTPUT
+	const int descriptor = fileno(output->stream);
+	struct iovec * vector = output->chunks;
+	unsigned int count = output->chunkCount;
+	while (0 < count && !output->failed) {
+		ssize_t written = writev(descriptor, vector, count);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			logError(_logger, "Cannot write the output: %s.", strerror(errno));
+			output->failed = true;
+			break;
+		}
+		while (0 < count && vector->iov_len <= (size_t) written) {
+			written -= vector->iov_len;
+			++vector;
+			--count;
+		}
+		if (0 < count) {
+			vector->iov_base = (char *) vector->iov_base + written;
+			vector->iov_len -= written;
+		}
+	}
+#else
+	for (unsigned int k = 0; k < output->chunkCount && !output->failed; ++k) {
+		if (fwrite(output->chunks[k].iov_base, 1, output->chunks[k].iov_len, output->stream) < output->chunks[k].iov_len) {
+			logError(_logger, "Cannot write the output.");
+			output->failed = true;
+		}
+	}
+	fflush(output->stream);
+#endif
+
+	output->used = 0;
+	output->chunkCount = 0;
+	output->pending = 0;
+	output->flushed = true;
+}
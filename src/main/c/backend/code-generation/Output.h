@@ -0,0 +1,88 @@
+#ifndef OUTPUT_HEADER
+#define OUTPUT_HEADER
+
+#include "../../shared/Environment.h"
+#include "../../shared/Logger.h"
+#include "../../shared/Type.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The vectored output is only available on POSIX systems. Otherwise, every
+ * chunk is written with "fwrite".
+ */
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#define VECTORED_OUTPUT
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+/**
+ * When the buffered output reaches the standard output.
+ */
+typedef enum {
+	// Only when the buffer is full, and at exit.
+	FLUSH_ON_EXIT,
+
+	// Every time the pending output reaches "OUTPUT_FLUSH_BYTES".
+	FLUSH_PER_BYTES,
+
+	// After every line (the default for terminals).
+	FLUSH_PER_LINE
+} FlushPolicy;
+
+/**
+ * A buffered output over a stream. Every execution has its own, so many
+ * programs can run at the same time.
+ */
+typedef struct Output Output;
+
+/**
+ * Initialize module's internal state. The flush policy is taken from the
+ * "OUTPUT_FLUSH_POLICY" environment variable ("EXIT", "BYTES" or "LINE").
+ */
+void initializeOutputModule();
+
+/**
+ * Shutdown module's internal state.
+ */
+void shutdownOutputModule();
+
+/**
+ * Creates an empty output over a stream. Returns NULL if the system runs out
+ * of memory.
+ */
+Output * createOutput(FILE * stream);
+
+/**
+ * Flushes the pending output, and destroys it (but not its stream).
+ */
+void destroyOutput(Output * output);
+
+/**
+ * Copies a chunk into the output buffer.
+ */
+void writeOutput(Output * output, const char * chunk, const size_t length);
+
+/**
+ * Appends a chunk to the output without copying it, so it must remain valid
+ * and unchanged until the next flush (e.g., a constant of the program).
+ */
+void referenceOutput(Output * output, const char * chunk, const size_t length);
+
+/**
+ * Sends the pending output to its stream, in as few system calls as
+ * possible.
+ */
+void flushOutput(Output * output);
+
+/**
+ * Flushes at a boundary of the program, like between the statements of a
+ * streamed program: the first output is sent right away (to reach the reader
+ * as soon as possible), and the rest every "OUTPUT_FLUSH_BYTES".
+ */
+void flushOutputAtBoundary(Output * output);
+
+#endif
@@ -0,0 +1,510 @@
+#include "VirtualMachine.h"
+
+#define MAXIMUM_CALL_DEPTH		65536
+
+/**
+ * GCC and Clang support "labels as values", which allows a threaded dispatch
+ * (one indirect jump per instruction, and better branch prediction). Other
+ * compilers fall back to a regular switch.
+ *
+ * @see https://gcc.gnu.org/onlinedocs/gcc/Labels-as-Values.html
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define COMPUTED_GOTO_DISPATCH
+#endif
+
+/**
+ * A value of the operand stack or of a slot: an atomic value, or a string
+ * (owned). Its type is known during the compilation, so it has no tag.
+ */
+typedef union {
+	int64_t atomic;
+	String string;
+} Value;
+
+/**
+ * A string is the biggest member, so the strings of consecutive values are
+ * an array too (the builtins with many arguments take them as such).
+ */
+_Static_assert(sizeof(Value) == sizeof(String), "A value must be as big as a string.");
+
+/**
+ * The state of an execution: the variables (slots) outlive every run, so a
+ * streamed program can be executed statement by statement.
+ */
+struct VirtualMachine {
+	Output * output;
+	Value * slots;
+	ConstantType * slotTypes;
+	unsigned int slotCount;
+	Value * stack;
+	unsigned int stackCapacity;
+	const uint32_t ** frames;
+	unsigned int frameCapacity;
+};
+
+/* MODULE INTERNAL STATE */
+
+static Logger * _logger = NULL;
+
+void initializeVirtualMachineModule() {
+	_logger = createLogger("VirtualMachine");
+}
+
+void shutdownVirtualMachineModule() {
+	if (_logger != NULL) {
+		destroyLogger(_logger);
+	}
+}
+
+//------------------------------------------------------------------------------------------------------
+
+/** PRIVATE FUNCTIONS */
+
+static boolean _reserve(VirtualMachine * virtualMachine, const BytecodeProgram * bytecodeProgram);
+static String _interpolate(const uint32_t * fragments, const unsigned int count, const char ** constants, const size_t * constantLengths, const Value * slots);
+static void _writeLeaf(const char * characters, const size_t length, void * output);
+static void _writeString(Output * output, const String * string);
+
+//------------------------------------------------------------------------------------------------------
+
+/**
+ * Grows the slots and the stack up to the needs of a program.
+ */
+static boolean _reserve(VirtualMachine * virtualMachine, const BytecodeProgram * bytecodeProgram) {
+	if (virtualMachine->slotCount < bytecodeProgram->slotCount) {
+		Value * slots = realloc(virtualMachine->slots, bytecodeProgram->slotCount * sizeof(Value));
+		if (slots != NULL) {
+			virtualMachine->slots = slots;
+		}
+		ConstantType * slotTypes = realloc(virtualMachine->slotTypes, bytecodeProgram->slotCount * sizeof(ConstantType));
+		if (slotTypes != NULL) {
+			virtualMachine->slotTypes = slotTypes;
+		}
+		if (slots == NULL || slotTypes == NULL) {
+			return false;
+		}
+		// Both an empty string and a zero.
+		memset(slots + virtualMachine->slotCount, 0, (bytecodeProgram->slotCount - virtualMachine->slotCount) * sizeof(Value));
+		memcpy(slotTypes + virtualMachine->slotCount, bytecodeProgram->slotTypes + virtualMachine->slotCount,
+			(bytecodeProgram->slotCount - virtualMachine->slotCount) * sizeof(ConstantType));
+		virtualMachine->slotCount = bytecodeProgram->slotCount;
+	}
+	if (virtualMachine->stackCapacity < 1 + bytecodeProgram->maximumStackDepth) {
+		Value * stack = realloc(virtualMachine->stack, (1 + bytecodeProgram->maximumStackDepth) * sizeof(Value));
+		if (stack == NULL) {
+			return false;
+		}
+		virtualMachine->stack = stack;
+		virtualMachine->stackCapacity = 1 + bytecodeProgram->maximumStackDepth;
+	}
+	return true;
+}
+
+/**
+ * Joins the fragments in order, straight from the constant pool and the
+ * slots: the first pass sizes the result, and the second one fills it, so
+ * there is a single allocation. The atomic variables are formatted in place,
+ * and a lone string variable is just shared.
+ */
+static String _interpolate(const uint32_t * fragments, const unsigned int count, const char ** constants, const size_t * constantLengths, const Value * slots) {
+	if (count == 1 && (fragments[0] & (FRAGMENT_SLOT_FLAG | FRAGMENT_ATOMIC_FLAG)) == FRAGMENT_SLOT_FLAG) {
+		return copyString(&slots[fragments[0] & FRAGMENT_OPERAND_MASK].string);
+	}
+	char atomic[ATOMIC_BUFFER_SIZE];
+	size_t length = 0;
+	for (unsigned int k = 0; k < count; ++k) {
+		const Value * slot = &slots[fragments[k] & FRAGMENT_OPERAND_MASK];
+		if (fragments[k] & FRAGMENT_ATOMIC_FLAG) {
+			length += formatAtomic(slot->atomic, atomic);
+		}
+		else if (fragments[k] & FRAGMENT_SLOT_FLAG) {
+			length += slot->string.length;
+		}
+		else {
+			length += constantLengths[fragments[k]];
+		}
+	}
+
+	String result = { 0 };
+	char * destiny = allocateString(&result, length);
+	if (destiny == NULL) {
+		return result;
+	}
+	for (unsigned int k = 0; k < count; ++k) {
+		const Value * slot = &slots[fragments[k] & FRAGMENT_OPERAND_MASK];
+		if (fragments[k] & FRAGMENT_ATOMIC_FLAG) {
+			destiny += formatAtomic(slot->atomic, destiny);
+		}
+		else if (fragments[k] & FRAGMENT_SLOT_FLAG) {
+			destiny = copyCharacters(&slot->string, destiny);
+		}
+		else {
+			memcpy(destiny, constants[fragments[k]], constantLengths[fragments[k]]);
+			destiny += constantLengths[fragments[k]];
+		}
+	}
+	result.ascii = isAscii(getCharacters(&result), length);
+
+	return result;
+}
+
+static void _writeLeaf(const char * characters, const size_t length, void * output) {
+	writeOutput(output, characters, length);
+}
+
+/**
+ * A rope is written leaf by leaf, so it's never flattened.
+ */
+static void _writeString(Output * output, const String * string) {
+	if (string->rope) {
+		visitString(string, _writeLeaf, output);
+	}
+	else {
+		writeOutput(output, getCharacters(string), string->length);
+	}
+}
+
+//------------------------------------------------------------------------------------------------------
+
+/** PUBLIC FUNCTIONS */
+
+VirtualMachine * createVirtualMachine(Output * output) {
+	VirtualMachine * virtualMachine = calloc(1, sizeof(VirtualMachine));
+	if (virtualMachine == NULL) {
+		return NULL;
+	}
+	virtualMachine->output = output;
+	virtualMachine->frameCapacity = 64;
+	virtualMachine->frames = malloc(virtualMachine->frameCapacity * sizeof(uint32_t *));
+	if (virtualMachine->frames == NULL) {
+		free(virtualMachine);
+		return NULL;
+	}
+	return virtualMachine;
+}
+
+void destroyVirtualMachine(VirtualMachine * virtualMachine) {
+	if (virtualMachine == NULL) { return; }
+
+	for (unsigned int k = 0; k < virtualMachine->slotCount; ++k) {
+		if (virtualMachine->slotTypes[k] != ATOMIC_TYPE) {
+			destroyString(&virtualMachine->slots[k].string);
+		}
+	}
+	free(virtualMachine->frames);
+	free(virtualMachine->slots);
+	free(virtualMachine->slotTypes);
+	free(virtualMachine->stack);
+	free(virtualMachine);
+}
+
+boolean execute(BytecodeProgram * bytecodeProgram, Output * output) {
+	VirtualMachine * virtualMachine = createVirtualMachine(output);
+	if (virtualMachine == NULL) {
+		logError(_logger, "Cannot create the virtual machine.");
+		return false;
+	}
+	const boolean succeed = run(virtualMachine, bytecodeProgram, 0);
+	destroyVirtualMachine(virtualMachine);
+	return succeed;
+}
+
+boolean run(VirtualMachine * virtualMachine, BytecodeProgram * bytecodeProgram, const unsigned int entry) {
+	logDebugging(_logger, "Executing %u words of bytecode (from %u)...", bytecodeProgram->codeSize, entry);
+
+	if (!_reserve(virtualMachine, bytecodeProgram)) {
+		logError(_logger, "Cannot reserve %u slots.", bytecodeProgram->slotCount);
+		return false;
+	}
+
+	const uint32_t * const code = bytecodeProgram->code;
+	const char ** const constants = bytecodeProgram->constants;
+	const size_t * const constantLengths = bytecodeProgram->constantLengths;
+	Finder ** const finders = bytecodeProgram->finders;
+	Automaton ** const automata = bytecodeProgram->automata;
+	const int * const routineEntries = bytecodeProgram->routineEntries;
+	Output * const output = virtualMachine->output;
+
+	Value * const stack = virtualMachine->stack;
+	Value * const slots = virtualMachine->slots;
+	unsigned int frameCapacity = virtualMachine->frameCapacity;
+	unsigned int frameCount = 0;
+	const uint32_t ** frames = virtualMachine->frames;
+
+	const uint32_t * instruction = code + entry;
+	Value * top = stack - 1;
+	char atomic[ATOMIC_BUFFER_SIZE];
+	boolean succeed = true;
+
+#ifdef COMPUTED_GOTO_DISPATCH
+	static const void * dispatchTable[OPCODE_COUNT] = {
+		[OP_HALT] = &&INSTRUCTION_HALT,
+		[OP_PUSH_CONSTANT] = &&INSTRUCTION_PUSH_CONSTANT,
+		[OP_PUSH_ATOMIC] = &&INSTRUCTION_PUSH_ATOMIC,
+		[OP_LOAD] = &&INSTRUCTION_LOAD,
+		[OP_LOAD_ATOMIC] = &&INSTRUCTION_LOAD_ATOMIC,
+		[OP_STORE] = &&INSTRUCTION_STORE,
+		[OP_STORE_ATOMIC] = &&INSTRUCTION_STORE_ATOMIC,
+		[OP_POP] = &&INSTRUCTION_POP,
+		[OP_POP_ATOMIC] = &&INSTRUCTION_POP_ATOMIC,
+		[OP_TO_STRING] = &&INSTRUCTION_TO_STRING,
+		[OP_TO_ATOMIC] = &&INSTRUCTION_TO_ATOMIC,
+		[OP_ADD] = &&INSTRUCTION_ADD,
+		[OP_SUBTRACT] = &&INSTRUCTION_SUBTRACT,
+		[OP_MULTIPLY] = &&INSTRUCTION_MULTIPLY,
+		[OP_DIVIDE] = &&INSTRUCTION_DIVIDE,
+		[OP_CONCATENATE] = &&INSTRUCTION_CONCATENATE,
+		[OP_REV] = &&INSTRUCTION_REV,
+		[OP_TUP] = &&INSTRUCTION_TUP,
+		[OP_TLO] = &&INSTRUCTION_TLO,
+		[OP_LEN] = &&INSTRUCTION_LEN,
+		[OP_RPL] = &&INSTRUCTION_RPL,
+		[OP_RPL_CONSTANT] = &&INSTRUCTION_RPL_CONSTANT,
+		[OP_MRP] = &&INSTRUCTION_MRP,
+		[OP_MRP_CONSTANT] = &&INSTRUCTION_MRP_CONSTANT,
+		[OP_ECP] = &&INSTRUCTION_ECP,
+		[OP_RND] = &&INSTRUCTION_RND,
+		[OP_INTERPOLATE] = &&INSTRUCTION_INTERPOLATE,
+		[OP_OUT] = &&INSTRUCTION_OUT,
+		[OP_OUT_ATOMIC] = &&INSTRUCTION_OUT_ATOMIC,
+		[OP_WRITE_CONSTANT] = &&INSTRUCTION_WRITE_CONSTANT,
+		[OP_WRITE_SLOT] = &&INSTRUCTION_WRITE_SLOT,
+		[OP_WRITE_ATOMIC_SLOT] = &&INSTRUCTION_WRITE_ATOMIC_SLOT,
+		[OP_CALL] = &&INSTRUCTION_CALL,
+		[OP_RETURN] = &&INSTRUCTION_RETURN,
+		[OP_JUMP] = &&INSTRUCTION_JUMP
+	};
+	#define INSTRUCTION(opcode) INSTRUCTION_##opcode:
+	#define DISPATCH() goto *dispatchTable[*instruction++]
+	DISPATCH();
+#else
+	#define INSTRUCTION(opcode) case OP_##opcode:
+	#define DISPATCH() continue
+	for (;;) switch (*instruction++) {
+#endif
+
+	INSTRUCTION(PUSH_CONSTANT) {
+		const uint32_t constant = *instruction++;
+		(++top)->string = createString(constants[constant], constantLengths[constant]);
+		DISPATCH();
+	}
+	INSTRUCTION(PUSH_ATOMIC) {
+		(++top)->atomic = (int64_t) ((uint64_t) instruction[0] | (uint64_t) instruction[1] << 32);
+		instruction += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(LOAD) {
+		(++top)->string = copyString(&slots[*instruction++].string);
+		DISPATCH();
+	}
+	INSTRUCTION(LOAD_ATOMIC) {
+		*++top = slots[*instruction++];
+		DISPATCH();
+	}
+	INSTRUCTION(STORE) {
+		Value * slot = &slots[*instruction++];
+		destroyString(&slot->string);
+		*slot = *top--;
+		DISPATCH();
+	}
+	INSTRUCTION(STORE_ATOMIC) {
+		slots[*instruction++] = *top--;
+		DISPATCH();
+	}
+	INSTRUCTION(POP) {
+		destroyString(&(top--)->string);
+		DISPATCH();
+	}
+	INSTRUCTION(POP_ATOMIC) {
+		--top;
+		DISPATCH();
+	}
+	INSTRUCTION(TO_STRING) {
+		const size_t length = formatAtomic(top->atomic, atomic);
+		top->string = createString(atomic, length);
+		DISPATCH();
+	}
+	INSTRUCTION(TO_ATOMIC) {
+		flattenString(&top->string);
+		const int64_t value = parseAtomic(getCharacters(&top->string));
+		destroyString(&top->string);
+		top->atomic = value;
+		DISPATCH();
+	}
+	INSTRUCTION(ADD) {
+		--top;
+		if (!builtinArithmetic(ADDITION, top[0].atomic, top[1].atomic, &top->atomic)) { goto OVERFLOW; }
+		DISPATCH();
+	}
+	INSTRUCTION(SUBTRACT) {
+		--top;
+		if (!builtinArithmetic(SUBTRACTION, top[0].atomic, top[1].atomic, &top->atomic)) { goto OVERFLOW; }
+		DISPATCH();
+	}
+	INSTRUCTION(MULTIPLY) {
+		--top;
+		if (!builtinArithmetic(MULTIPLICATION, top[0].atomic, top[1].atomic, &top->atomic)) { goto OVERFLOW; }
+		DISPATCH();
+	}
+	INSTRUCTION(DIVIDE) {
+		--top;
+		if (!builtinArithmetic(DIVISION, top[0].atomic, top[1].atomic, &top->atomic)) {
+			if (top[1].atomic == 0) {
+				logError(_logger, "Division by zero.");
+				succeed = false;
+				goto HALTED;
+			}
+			goto OVERFLOW;
+		}
+		DISPATCH();
+	}
+	INSTRUCTION(CONCATENATE) {
+		--top;
+		top->string = concatenateStrings(&top[0].string, &top[1].string);
+		DISPATCH();
+	}
+	INSTRUCTION(REV) {
+		top->string = builtinReverse(&top->string);
+		DISPATCH();
+	}
+	INSTRUCTION(TUP) {
+		top->string = builtinToUpper(&top->string);
+		DISPATCH();
+	}
+	INSTRUCTION(TLO) {
+		top->string = builtinToLower(&top->string);
+		DISPATCH();
+	}
+	INSTRUCTION(LEN) {
+		top->atomic = builtinLength(&top->string);
+		DISPATCH();
+	}
+	INSTRUCTION(RPL) {
+		top -= 2;
+		top->string = builtinReplace(&top[0].string, &top[1].string, &top[2].string);
+		DISPATCH();
+	}
+	INSTRUCTION(RPL_CONSTANT) {
+		const uint32_t finder = *instruction++;
+		top -= 1;
+		top->string = builtinReplaceWith(finders[finder], &top[0].string, &top[1].string);
+		DISPATCH();
+	}
+	INSTRUCTION(MRP) {
+		const uint32_t count = *instruction++;
+		top -= 2 * count;
+		top->string = builtinReplaceAll(&top[0].string, &top[1].string, count);
+		DISPATCH();
+	}
+	INSTRUCTION(MRP_CONSTANT) {
+		const Automaton * automaton = automata[*instruction++];
+		top -= automaton->targetCount;
+		top->string = builtinReplaceAllWith(automaton, &top[0].string, &top[1].string);
+		DISPATCH();
+	}
+	INSTRUCTION(ECP) {
+		top -= 1;
+		top->string = builtinEncrypt(&top[0].string, &top[1].string);
+		DISPATCH();
+	}
+	INSTRUCTION(RND) {
+		top -= 2;
+		top->string = builtinRandom(top[0].atomic, top[1].atomic, &top[2].string);
+		DISPATCH();
+	}
+	INSTRUCTION(INTERPOLATE) {
+		const uint32_t count = *instruction++;
+		(++top)->string = _interpolate(instruction, count, constants, constantLengths, slots);
+		instruction += count;
+		DISPATCH();
+	}
+	INSTRUCTION(OUT) {
+		_writeString(output, &top->string);
+		referenceOutput(output, "\n", 1);
+		destroyString(&(top--)->string);
+		DISPATCH();
+	}
+	INSTRUCTION(OUT_ATOMIC) {
+		writeOutput(output, atomic, formatAtomic((top--)->atomic, atomic));
+		referenceOutput(output, "\n", 1);
+		DISPATCH();
+	}
+	INSTRUCTION(WRITE_CONSTANT) {
+		const uint32_t constant = *instruction++;
+		referenceOutput(output, constants[constant], constantLengths[constant]);
+		DISPATCH();
+	}
+	INSTRUCTION(WRITE_SLOT) {
+		_writeString(output, &slots[*instruction++].string);
+		DISPATCH();
+	}
+	INSTRUCTION(WRITE_ATOMIC_SLOT) {
+		writeOutput(output, atomic, formatAtomic(slots[*instruction++].atomic, atomic));
+		DISPATCH();
+	}
+	INSTRUCTION(CALL) {
+		const int entry = routineEntries[*instruction++];
+		if (entry < 0) {
+			logError(_logger, "Call to an undefined routine.");
+			succeed = false;
+			goto HALTED;
+		}
+		if (frameCount == frameCapacity) {
+			if (MAXIMUM_CALL_DEPTH <= frameCapacity) {
+				logError(_logger, "Maximum routine call depth exceeded (%d).", MAXIMUM_CALL_DEPTH);
+				succeed = false;
+				goto HALTED;
+			}
+			const uint32_t ** grownFrames = realloc(frames, 2 * frameCapacity * sizeof(uint32_t *));
+			if (grownFrames == NULL) {
+				logError(_logger, "Cannot grow the call stack beyond %u frames.", frameCapacity);
+				succeed = false;
+				goto HALTED;
+			}
+			frames = grownFrames;
+			frameCapacity *= 2;
+		}
+		frames[frameCount++] = instruction;
+		instruction = code + entry;
+		DISPATCH();
+	}
+	INSTRUCTION(RETURN) {
+		instruction = frames[--frameCount];
+		DISPATCH();
+	}
+	INSTRUCTION(JUMP) {
+		instruction = code + *instruction;
+		DISPATCH();
+	}
+	INSTRUCTION(HALT) {
+		goto HALTED;
+	}
+
+#ifndef COMPUTED_GOTO_DISPATCH
+	default:
+		logError(_logger, "Unknown opcode: %u", instruction[-1]);
+		succeed = false;
+		goto HALTED;
+	}
+#endif
+
+	#undef DISPATCH
+	#undef INSTRUCTION
+
+OVERFLOW:
+	logError(_logger, "Atomic overflow: the result is out of the range [%" PRId64 ", %" PRId64 "].", INT64_MIN, INT64_MAX);
+	succeed = false;
+
+HALTED:
+	// The stack is empty, unless the execution was aborted. Then the types of
+	// its values are unknown, so the strings are leaked (and it's rare).
+	if (stack <= top) {
+		logDebugging(_logger, "Dropping %ld values from the stack.", (long) (top - stack + 1));
+	}
+	virtualMachine->frames = frames;
+	virtualMachine->frameCapacity = frameCapacity;
+
+	logDebugging(_logger, "Execution is done.");
+	return succeed;
+}
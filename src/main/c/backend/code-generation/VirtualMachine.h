@@ -0,0 +1,52 @@
+#ifndef VIRTUAL_MACHINE_HEADER
+#define VIRTUAL_MACHINE_HEADER
+
+#include "../../shared/Environment.h"
+#include "../../shared/Logger.h"
+#include "../../shared/Type.h"
+#include "Builtins.h"
+#include "Bytecode.h"
+#include "Output.h"
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * A virtual machine, with the variables of a program. Every execution has
+ * its own, so many programs can run at the same time.
+ */
+typedef struct VirtualMachine VirtualMachine;
+
+/** Initialize module's internal state. */
+void initializeVirtualMachineModule();
+
+/** Shutdown module's internal state. */
+void shutdownVirtualMachineModule();
+
+/**
+ * Runs a compiled program until it halts, writing into an output. Returns
+ * false if the execution was aborted due to a runtime failure.
+ */
+boolean execute(BytecodeProgram * bytecodeProgram, Output * output);
+
+/**
+ * Creates a virtual machine that writes into an output, with no variables.
+ * Returns NULL if the system runs out of memory.
+ */
+VirtualMachine * createVirtualMachine(Output * output);
+
+/**
+ * Destroy a virtual machine, and its variables.
+ */
+void destroyVirtualMachine(VirtualMachine * virtualMachine);
+
+/**
+ * Runs a program from an address until it halts. The variables keep their
+ * values across runs, so the statements of a streamed program can be run one
+ * after the other. Returns false on a runtime failure.
+ */
+boolean run(VirtualMachine * virtualMachine, BytecodeProgram * bytecodeProgram, const unsigned int entry);
+
+#endif
@@ -0,0 +1,428 @@
+#include "ConstantFolding.h"
+
+/**
+ * The value of a variable is known since its declaration, but a variable
+ * declared inside a routine is empty until the routine runs. So the values
+ * declared at the top-level hold everywhere after them, and the ones
+ * declared in a routine, only in the rest of its body (not even in the
+ * routines nested in it, which can be called before).
+ */
+struct ConstantFolder {
+	Interner * interner;
+	ExpressionPool * expressionPool;
+	Expression * expressions;
+	SymbolTable * symbolTable;
+
+	// The interned value of every slot (or NULL if it's unknown), and the
+	// depth of the routine where it was declared (zero at the top-level).
+	const char ** values;
+	unsigned int * depths;
+	unsigned int slotCount;
+	unsigned int depth;
+
+	// The amount of expressions folded (for statistics).
+	unsigned int folded;
+};
+
+/* MODULE INTERNAL STATE */
+
+static Logger * _logger = NULL;
+
+void initializeConstantFoldingModule() {
+	_logger = createLogger("ConstantFolding");
+}
+
+void shutdownConstantFoldingModule() {
+	if (_logger != NULL) {
+		destroyLogger(_logger);
+	}
+}
+
+//------------------------------------------------------------------------------------------------------
+
+/** PRIVATE FUNCTIONS */
+
+static boolean _reserveSlots(ConstantFolder * folder);
+static boolean _isReserved(ConstantFolder * folder, const int slot);
+static const char * _knownValue(ConstantFolder * folder, const int slot);
+static void _declareValue(ConstantFolder * folder, const int slot, const char * value);
+static const char * _internAtomic(ConstantFolder * folder, const int64_t value);
+static const char * _rewrite(ConstantFolder * folder, Expression * expression, const char * value);
+static const char * _rewriteWithResult(ConstantFolder * folder, Expression * expression, String result);
+static String _argument(const char * value);
+static boolean _foldStatementList(ConstantFolder * folder, StatementList * list);
+static boolean _foldStatement(ConstantFolder * folder, Statement * statement);
+static boolean _foldRoutine(ConstantFolder * folder, Routine * routine);
+static const char * _foldExpression(ConstantFolder * folder, const ExpressionId id);
+static const char * _foldInterpolation(ConstantFolder * folder, Expression * expression);
+static const char * _foldMultipleReplace(ConstantFolder * folder, Expression * expression);
+
+//------------------------------------------------------------------------------------------------------
+
+/**
+ * Makes room for the values of every symbol defined so far.
+ */
+static boolean _reserveSlots(ConstantFolder * folder) {
+	const unsigned int slotCount = getSymbolCount(folder->symbolTable);
+	if (slotCount <= folder->slotCount) {
+		return true;
+	}
+
+	const char ** values = realloc(folder->values, slotCount * sizeof(char *));
+	if (values == NULL) {
+		return false;
+	}
+	folder->values = values;
+	unsigned int * depths = realloc(folder->depths, slotCount * sizeof(unsigned int));
+	if (depths == NULL) {
+		return false;
+	}
+	folder->depths = depths;
+	for (unsigned int k = folder->slotCount; k < slotCount; ++k) {
+		folder->values[k] = NULL;
+		folder->depths[k] = 0;
+	}
+	folder->slotCount = slotCount;
+	return true;
+}
+
+/**
+ * Whether a slot was resolved by the semantic analysis, and it's reserved.
+ */
+static boolean _isReserved(ConstantFolder * folder, const int slot) {
+	return slot != UNRESOLVED_SLOT && (unsigned int) slot < folder->slotCount;
+}
+
+static const char * _knownValue(ConstantFolder * folder, const int slot) {
+	if (!_isReserved(folder, slot) || folder->values[slot] == NULL) {
+		return NULL;
+	}
+	const unsigned int depth = folder->depths[slot];
+	return depth == 0 || depth == folder->depth ? folder->values[slot] : NULL;
+}
+
+static void _declareValue(ConstantFolder * folder, const int slot, const char * value) {
+	if (_isReserved(folder, slot)) {
+		folder->values[slot] = value;
+		folder->depths[slot] = folder->depth;
+	}
+}
+
+/**
+ * The folded values are kept as strings, so an atomic value is interned in
+ * decimal.
+ */
+static const char * _internAtomic(ConstantFolder * folder, const int64_t value) {
+	char buffer[ATOMIC_BUFFER_SIZE + 1];
+	buffer[formatAtomic(value, buffer)] = '\0';
+	return internString(folder->interner, buffer);
+}
+
+/**
+ * Turns an expression into a constant of the same type, with an interned
+ * value. Its operands are left unreferenced in the pool.
+ */
+static const char * _rewrite(ConstantFolder * folder, Expression * expression, const char * value) {
+	if (value == NULL) {
+		return NULL;
+	}
+	if (expression->valueType == ATOMIC_TYPE) {
+		expression->type = ATOMIC_CONSTANT_EXPRESSION;
+		expression->atomic = parseAtomic(value);
+	}
+	else {
+		expression->type = STRING_CONSTANT_EXPRESSION;
+		expression->string = (char *) value;
+	}
+	++folder->folded;
+	return value;
+}
+
+/**
+ * Like "_rewrite", but with the result of a builtin, which gets flattened
+ * and interned (and released).
+ */
+static const char * _rewriteWithResult(ConstantFolder * folder, Expression * expression, String result) {
+	flattenString(&result);
+	const char * value = intern(folder->interner, getCharacters(&result), result.length);
+	destroyString(&result);
+	return _rewrite(folder, expression, value);
+}
+
+/**
+ * A copy of a folded value, to be consumed by a builtin.
+ */
+static String _argument(const char * value) {
+	return createString(value, strlen(value));
+}
+
+static boolean _foldStatementList(ConstantFolder * folder, StatementList * list) {
+	if (list == NULL) { return true; }
+
+	for (unsigned int k = 0; k < list->count; ++k) {
+		if (!_foldStatement(folder, list->statements[k])) { return false; }
+	}
+	return true;
+}
+
+static boolean _foldStatement(ConstantFolder * folder, Statement * statement) {
+	if (!_reserveSlots(folder)) {
+		logError(_logger, "Cannot reserve %u slots.", getSymbolCount(folder->symbolTable));
+		return false;
+	}
+
+	switch (statement->type) {
+		case STATEMENT_DECLARATION: {
+			Declaration * declaration = statement->declaration;
+			if (declaration->type == STRING_TYPE || declaration->type == ATOMIC_TYPE) {
+				const char * value = _foldExpression(folder, declaration->expression);
+				if (value != NULL) {
+					_declareValue(folder, declaration->slot, value);
+				}
+			}
+			return true;
+		}
+		case STATEMENT_EXPRESSION:
+		case STATEMENT_OUTPUT:
+			_foldExpression(folder, statement->expression);
+			return true;
+		case STATEMENT_ROUTINE:
+			return _foldRoutine(folder, statement->routine);
+		default:
+			return true;
+	}
+}
+
+/**
+ * The values declared in the body of a routine are forgotten at its end.
+ */
+static boolean _foldRoutine(ConstantFolder * folder, Routine * routine) {
+	++folder->depth;
+	const boolean succeed = _foldStatementList(folder, routine->body);
+	for (unsigned int k = 0; routine->body != NULL && k < routine->body->count; ++k) {
+		Statement * statement = routine->body->statements[k];
+		if (statement->type == STATEMENT_DECLARATION) {
+			_declareValue(folder, statement->declaration->slot, NULL);
+		}
+	}
+	--folder->depth;
+	return succeed;
+}
+
+/**
+ * Folds the operands first (bottom-up), and returns the value of the
+ * expression if it's constant, or NULL otherwise. The builtins take the
+ * ownership of their arguments, so the operands are copied.
+ */
+static const char * _foldExpression(ConstantFolder * folder, const ExpressionId id) {
+	if (id == NO_EXPRESSION) { return NULL; }
+
+	Expression * expression = &folder->expressions[id];
+	const char * operands[3] = { NULL, NULL, NULL };
+
+	switch (expression->type) {
+		case STRING_CONSTANT_EXPRESSION:
+			return expression->string == NULL ? "" : expression->string;
+		case ATOMIC_CONSTANT_EXPRESSION:
+			return _internAtomic(folder, expression->atomic);
+		case IDENTIFIER_EXPRESSION: {
+			const char * value = _knownValue(folder, expression->slot);
+			return value == NULL ? NULL : _rewrite(folder, expression, value);
+		}
+		case INTERPOLATION_EXPRESSION:
+			return _foldInterpolation(folder, expression);
+		case EXPRESSION_REV:
+		case EXPRESSION_TUP:
+		case EXPRESSION_TLO:
+		case EXPRESSION_LEN:
+			if ((operands[0] = _foldExpression(folder, expression->operands[0])) == NULL) { return NULL; }
+			break;
+		case EXPRESSION_ECP:
+			operands[0] = _foldExpression(folder, expression->operands[0]);
+			operands[1] = _foldExpression(folder, expression->operands[1]);
+			if (operands[0] == NULL || operands[1] == NULL) { return NULL; }
+			break;
+		case EXPRESSION_RPL:
+			operands[0] = _foldExpression(folder, expression->operands[0]);
+			operands[1] = _foldExpression(folder, expression->operands[1]);
+			operands[2] = _foldExpression(folder, expression->operands[2]);
+			if (operands[0] == NULL || operands[1] == NULL || operands[2] == NULL) { return NULL; }
+			break;
+		case ARITHMETIC_EXPRESSION: {
+			// An overflow (or a division by zero) is left to fail at runtime.
+			operands[0] = _foldExpression(folder, expression->operands[0]);
+			operands[1] = _foldExpression(folder, expression->operands[1]);
+			int64_t result = 0;
+			if (expression->valueType == STRING_TYPE) {
+				if (operands[0] == NULL || operands[1] == NULL) { return NULL; }
+				break;
+			}
+			if (operands[0] == NULL || operands[1] == NULL
+				|| !builtinArithmetic(expression->operator, parseAtomic(operands[0]), parseAtomic(operands[1]), &result)) {
+				return NULL;
+			}
+			return _rewrite(folder, expression, _internAtomic(folder, result));
+		}
+		case EXPRESSION_MRP:
+			return _foldMultipleReplace(folder, expression);
+		case EXPRESSION_RND:
+			// Not pure: every evaluation gives a different value.
+			_foldExpression(folder, expression->operands[0]);
+			_foldExpression(folder, expression->operands[1]);
+			_foldExpression(folder, expression->operands[2]);
+			return NULL;
+		default:
+			return NULL;
+	}
+
+	// The missing operands are empty, so they never hold heap-memory.
+	String arguments[3] = {
+		_argument(operands[0]),
+		_argument(operands[1] == NULL ? "" : operands[1]),
+		_argument(operands[2] == NULL ? "" : operands[2])
+	};
+	switch (expression->type) {
+		case EXPRESSION_REV:
+			return _rewriteWithResult(folder, expression, builtinReverse(&arguments[0]));
+		case EXPRESSION_TUP:
+			return _rewriteWithResult(folder, expression, builtinToUpper(&arguments[0]));
+		case EXPRESSION_TLO:
+			return _rewriteWithResult(folder, expression, builtinToLower(&arguments[0]));
+		case EXPRESSION_LEN:
+			return _rewrite(folder, expression, _internAtomic(folder, builtinLength(&arguments[0])));
+		case EXPRESSION_ECP:
+			return _rewriteWithResult(folder, expression, builtinEncrypt(&arguments[0], &arguments[1]));
+		case ARITHMETIC_EXPRESSION:
+			return _rewriteWithResult(folder, expression, concatenateStrings(&arguments[0], &arguments[1]));
+		default:
+			return _rewriteWithResult(folder, expression, builtinReplace(&arguments[0], &arguments[1], &arguments[2]));
+	}
+}
+
+/**
+ * Every target and replacement is folded, so the targets that become
+ * constant get their automaton built during the compilation. If all of them
+ * (and the original) are constant, so is the whole MRP.
+ */
+static const char * _foldMultipleReplace(ConstantFolder * folder, Expression * expression) {
+	unsigned int count = 0;
+	for (ExpressionId pair = expression->operands[1]; pair != NO_EXPRESSION; pair = folder->expressions[pair].operands[2]) {
+		++count;
+	}
+	const char ** values = malloc((1 + 2 * count) * sizeof(char *));
+	if (values == NULL) {
+		return NULL;
+	}
+
+	values[0] = _foldExpression(folder, expression->operands[0]);
+	boolean constant = values[0] != NULL;
+	unsigned int k = 1;
+	for (ExpressionId pair = expression->operands[1]; pair != NO_EXPRESSION; pair = folder->expressions[pair].operands[2]) {
+		values[k] = _foldExpression(folder, folder->expressions[pair].operands[0]);
+		values[k + 1] = _foldExpression(folder, folder->expressions[pair].operands[1]);
+		constant = constant && values[k] != NULL && values[k + 1] != NULL;
+		k += 2;
+	}
+
+	String * arguments = constant ? malloc((1 + 2 * count) * sizeof(String)) : NULL;
+	const char * value = NULL;
+	if (arguments != NULL) {
+		for (k = 0; k < 1 + 2 * count; ++k) {
+			arguments[k] = _argument(values[k]);
+		}
+		value = _rewriteWithResult(folder, expression, builtinReplaceAll(&arguments[0], &arguments[1], count));
+	}
+	free(arguments);
+	free(values);
+	return value;
+}
+
+/**
+ * Every fragment with a known value becomes a literal. If all of them are
+ * literals, the interpolation is joined into a single constant.
+ */
+static const char * _foldInterpolation(ConstantFolder * folder, Expression * expression) {
+	Interpolation * interpolation = expression->interpolation;
+	size_t length = 0;
+	boolean constant = true;
+
+	for (InterpolationFragmentList * current = interpolation ? interpolation->fragments : NULL; current; current = current->next) {
+		InterpolationFragment * fragment = current->head;
+		if (fragment->type == EXPRESSION_FRAGMENT) {
+			const char * value = _knownValue(folder, fragment->slot);
+			if (value == NULL) {
+				constant = false;
+				continue;
+			}
+			fragment->type = LITERAL_FRAGMENT;
+			fragment->literal = (char *) value;
+		}
+		if (fragment->type != LITERAL_FRAGMENT) {
+			constant = false;
+			continue;
+		}
+		length += fragment->literal == NULL ? 0 : strlen(fragment->literal);
+	}
+	if (!constant) {
+		return NULL;
+	}
+
+	String value = { 0 };
+	char * destiny = allocateString(&value, length);
+	if (destiny == NULL) {
+		return NULL;
+	}
+	for (InterpolationFragmentList * current = interpolation ? interpolation->fragments : NULL; current; current = current->next) {
+		if (current->head->literal != NULL) {
+			const size_t fragmentLength = strlen(current->head->literal);
+			memcpy(destiny, current->head->literal, fragmentLength);
+			destiny += fragmentLength;
+		}
+	}
+	return _rewriteWithResult(folder, expression, value);
+}
+
+//------------------------------------------------------------------------------------------------------
+
+/** PUBLIC FUNCTIONS */
+
+boolean foldConstants(CompilerState * compilerState, SymbolTable * symbolTable) {
+	logDebugging(_logger, "Folding constants...");
+
+	Program * program = compilerState->abstractSyntaxtTree;
+	ConstantFolder * folder = createConstantFolder(compilerState, symbolTable);
+	if (folder == NULL) {
+		logError(_logger, "Cannot create the constant folder.");
+		return false;
+	}
+
+	folder->expressions = compilerState->expressions->expressions;
+	const boolean succeed = program == NULL || _foldStatementList(folder, program->statements);
+	logDebugging(_logger, "Folding is done (%u expressions folded).", folder->folded);
+	destroyConstantFolder(folder);
+	return succeed;
+}
+
+ConstantFolder * createConstantFolder(CompilerState * compilerState, SymbolTable * symbolTable) {
+	ConstantFolder * folder = calloc(1, sizeof(ConstantFolder));
+	if (folder == NULL) {
+		return NULL;
+	}
+	folder->interner = compilerState->interner;
+	folder->expressionPool = compilerState->expressions;
+	folder->symbolTable = symbolTable;
+	return folder;
+}
+
+void destroyConstantFolder(ConstantFolder * folder) {
+	if (folder != NULL) {
+		free(folder->values);
+		free(folder->depths);
+		free(folder);
+	}
+}
+
+boolean foldStatement(ConstantFolder * folder, Statement * statement) {
+	folder->expressions = folder->expressionPool->expressions;
+	return _foldStatement(folder, statement);
+}
@@ -0,0 +1,55 @@
+#ifndef CONSTANT_FOLDING_HEADER
+#define CONSTANT_FOLDING_HEADER
+
+#include "../../frontend/syntactic-analysis/AbstractSyntaxTree.h"
+#include "../../shared/CompilerState.h"
+#include "../../shared/Interner.h"
+#include "../../shared/Logger.h"
+#include "../../shared/Type.h"
+#include "../code-generation/Builtins.h"
+#include "../semantic-analysis/SymbolTable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The state of the folding of a program: the values of the variables that
+ * are known at compile-time.
+ */
+typedef struct ConstantFolder ConstantFolder;
+
+/** Initialize module's internal state. */
+void initializeConstantFoldingModule();
+
+/** Shutdown module's internal state. */
+void shutdownConstantFoldingModule();
+
+/**
+ * Evaluates every pure builtin (all but RND) and arithmetic operation whose
+ * operands are constant, and rewrites it as a constant of the same type, in
+ * place. The value of the "String" and "Atomic" declarations is propagated
+ * to the variables that read them, and the interpolations whose fragments
+ * are all constant are joined. It must run after the semantic analysis
+ * (which infers the types), and before the code generation.
+ * Returns false if the system runs out of memory.
+ */
+boolean foldConstants(CompilerState * compilerState, SymbolTable * symbolTable);
+
+/**
+ * Creates a folder for a streamed program, whose top-level statements are
+ * folded one at a time. Returns NULL if the system runs out of memory.
+ */
+ConstantFolder * createConstantFolder(CompilerState * compilerState, SymbolTable * symbolTable);
+
+/**
+ * Destroy a folder (the folded values are kept in the interner).
+ */
+void destroyConstantFolder(ConstantFolder * constantFolder);
+
+/**
+ * Like "foldConstants", but over a single top-level statement of a streamed
+ * program (already analyzed).
+ */
+boolean foldStatement(ConstantFolder * constantFolder, Statement * statement);
+
+#endif
@@ -1,76 +1,95 @@
 #include "SemanticAnalyzer.h"
 
 static Logger* _logger = NULL;
-static SymbolTable* _symbolTable = NULL;
+
+/**
+ * The state of a single analysis. It's owned by the call, so many programs
+ * can be analyzed at the same time.
+ */
+typedef struct {
+	SymbolTable* symbolTable;
+	Expression* expressions;
+} SemanticAnalysis;
 
 //--------------------------------------------------------------------------
 
-static boolean _analyzeStatementList(StatementList* list);
-static boolean _analyzeStatement(Statement* Statement);
-static boolean _analyzeDeclaration(Declaration* declaration);
-static boolean _analyzeExpression(Expression* expression);
-static boolean _analyzeFactor(Factor* factor);
-static boolean _analyzeRoutine(Routine* routine);
-static boolean _analyzeInterpolation(Interpolation* interpolation);
-static boolean _analyzeInterpolationFragment(InterpolationFragment* fragment);
-static boolean _analyzeIdentifierFactor(Factor* factor);
+static boolean _analyzeStatementList(SemanticAnalysis* analysis, StatementList* list);
+static boolean _analyzeStatement(SemanticAnalysis* analysis, Statement* Statement);
+static boolean _analyzeDeclaration(SemanticAnalysis* analysis, Declaration* declaration);
+static boolean _analyzeExpression(SemanticAnalysis* analysis, ExpressionId id);
+static boolean _analyzeAtomicExpression(SemanticAnalysis* analysis, ExpressionId id);
+static boolean _analyzeAddition(SemanticAnalysis* analysis, Expression* expression);
+static boolean _analyzeRoutine(SemanticAnalysis* analysis, Routine* routine);
+static boolean _analyzeInterpolation(SemanticAnalysis* analysis, Interpolation* interpolation);
+static boolean _analyzeInterpolationFragment(SemanticAnalysis* analysis, InterpolationFragment* fragment);
+static boolean _analyzeIdentifier(SemanticAnalysis* analysis, Expression* expression);
 
 //--------------------------------------------------------------------------
 
-static void _initializeSemanticAnalyzerModule(SymbolTable* symbolTable) {
+void initializeSemanticAnalyzerModule() {
 	_logger = createLogger("SemanticAnalyzer");
-	_symbolTable = symbolTable;
 }
 
-static void _shutdownSemanticAnalyzerModule() {
-	destroyLogger(_logger);
-    _logger = NULL;
-    _symbolTable = NULL;
+void shutdownSemanticAnalyzerModule() {
+	if (_logger != NULL) {
+		destroyLogger(_logger);
+	}
 }
 
 static void _logSemanticAnalizer(const char* functionName) {
 	logDebugging(_logger, "%s", functionName);
 }
 
-static boolean _analyzeStatementList(StatementList* list) {
+static boolean _analyzeStatementList(SemanticAnalysis* analysis, StatementList* list) {
 	if (list == NULL) { return true; }
 
-	return _analyzeStatementList(list->next) && _analyzeStatement(list->statement);
+	for (unsigned int k = 0; k < list->count; ++k) {
+		if (!_analyzeStatement(analysis, list->statements[k])) {
+			return false;
+		}
+	}
+	return true;
 }
 
-static boolean _analyzeStatement(Statement* statement) {
+static boolean _analyzeStatement(SemanticAnalysis* analysis, Statement* statement) {
     _logSemanticAnalizer(__FUNCTION__);
 
 	if (statement == NULL) { return false; }
 
 	switch (statement->type) {
 		case STATEMENT_DECLARATION:
-			return _analyzeDeclaration(statement->declaration);
+			return _analyzeDeclaration(analysis, statement->declaration);
 		case STATEMENT_EXPRESSION:
-			return _analyzeExpression(statement->expression);
+			return _analyzeExpression(analysis, statement->expression);
 		case STATEMENT_ROUTINE:
-			return _analyzeRoutine(statement->routine);
+			return _analyzeRoutine(analysis, statement->routine);
 		case STATEMENT_ROUTINE_CALL: {
-			if (!isSymbolDefined(_symbolTable, statement->routineCallName)) {
+			Symbol* symbol = getSymbol(analysis->symbolTable, statement->routineCallName);
+			if (!symbol) {
 				logError(_logger, "Undefined routine: %s", statement->routineCallName);
 				return false;
 			}
+			if (symbol->kind != ROUTINE_SYMBOL) {
+				logError(_logger, "Symbol '%s' is not a routine", statement->routineCallName);
+				return false;
+			}
+			statement->routineCallSlot = symbol->slot;
 			return true;
 		}
 		case STATEMENT_OUTPUT:
-			return _analyzeExpression(statement->expression);
+			return _analyzeExpression(analysis, statement->expression);
 		default:
 			logError(_logger, "Unknown statement type.");
 			return false;
 	}
 }
 
-static boolean _analyzeDeclaration(Declaration* declaration) {
+static boolean _analyzeDeclaration(SemanticAnalysis* analysis, Declaration* declaration) {
     _logSemanticAnalizer(__FUNCTION__);
 
 	if (!declaration || !declaration->identifier) { return false; }
 
-	if (isSymbolDefined(_symbolTable, declaration->identifier)) {
+	if (isSymbolDefined(analysis->symbolTable, declaration->identifier)) {
 		logError(_logger, "Variable '%s' already declared", declaration->identifier);
 		return false;
 	}
@@ -80,24 +99,28 @@ static boolean _analyzeDeclaration(Declaration* declaration) {
 		.variable.type = declaration->type
 	};
 
-	if (!defineSymbol(_symbolTable, declaration->identifier, &symbol)) {
+	if (!defineSymbol(analysis->symbolTable, declaration->identifier, &symbol)) {
 		logError(_logger, "Failed to define symbol for: %s", declaration->identifier);
 		return false;
 	}
+	declaration->slot = symbol.slot;
 
-	if (declaration->type == STRING_TYPE || declaration->type == ATOMIC_TYPE || declaration->type == BUFFER_TYPE) { // Por ahora siempre TRUE
-		return true;
-	} else {
-		return _analyzeExpression(declaration->expression);
+	switch (declaration->type) {
+		case ATOMIC_TYPE:
+			return _analyzeAtomicExpression(analysis, declaration->expression);
+		case BUFFER_TYPE:
+			return true;
+		default:
+			return _analyzeExpression(analysis, declaration->expression);
 	}
 }
 
-static boolean _analyzeRoutine(Routine* routine) {
+static boolean _analyzeRoutine(SemanticAnalysis* analysis, Routine* routine) {
     _logSemanticAnalizer(__FUNCTION__);
 
 	if (!routine || !routine->identifier) { return false; }
 
-	if (isSymbolDefined(_symbolTable, routine->identifier)) {
+	if (isSymbolDefined(analysis->symbolTable, routine->identifier)) {
 		logError(_logger, "Routine '%s' already defined", routine->identifier);
 		return false;
 	}
@@ -107,44 +130,76 @@ static boolean _analyzeRoutine(Routine* routine) {
 		.routine = routine
 	};
 
-	if (!defineSymbol(_symbolTable, routine->identifier, &symbol)) {
+	if (!defineSymbol(analysis->symbolTable, routine->identifier, &symbol)) {
 		logError(_logger, "Failed to define routine: %s", routine->identifier);
 		return false;
 	}
+	routine->slot = symbol.slot;
 
-	return _analyzeStatementList(routine->body);
+	return _analyzeStatementList(analysis, routine->body);
 }
 
-static boolean _analyzeExpression(Expression* expression) {
+/**
+ * Also infers the type of the value of every expression: the atomic
+ * constants and variables, LEN, and the arithmetic, are atomic. Everything
+ * else is a string, and so is an addition with a string operand (which
+ * concatenates them).
+ */
+static boolean _analyzeExpression(SemanticAnalysis* analysis, ExpressionId id) {
     _logSemanticAnalizer(__FUNCTION__);
 
-	logDebugging(_logger, "EXPRESSION: %p", expression);
+	if (id == NO_EXPRESSION) { return false; }
+
+	Expression* expression = &analysis->expressions[id];
+	logDebugging(_logger, "EXPRESSION: %u", id);
 	logDebugging(_logger, "TYPE: %d", expression->type);
 
-	if (!expression) { return false; }
+	switch (expression->type) {
+		case ATOMIC_CONSTANT_EXPRESSION:
+		case ARITHMETIC_EXPRESSION:
+		case EXPRESSION_LEN:
+			expression->valueType = ATOMIC_TYPE;
+			break;
+		default:
+			expression->valueType = STRING_TYPE;
+			break;
+	}
 
 	switch (expression->type) {
+		case ATOMIC_CONSTANT_EXPRESSION:
+		case STRING_CONSTANT_EXPRESSION:
+		case BUFFER_CONSTANT_EXPRESSION:
+			return true;
+		case IDENTIFIER_EXPRESSION:
+			return _analyzeIdentifier(analysis, expression);
+		case INTERPOLATION_EXPRESSION:
+			return _analyzeInterpolation(analysis, expression->interpolation);
 		case ARITHMETIC_EXPRESSION:
-			return _analyzeExpression(expression->arithmetic->left) &&
-				   _analyzeExpression(expression->arithmetic->right);
-		case FACTOR_EXPRESSION:
-			return _analyzeFactor(expression->factor);
-		case EXPRESSION_RND:
-			return _analyzeExpression(expression->random->min) &&
-			       _analyzeExpression(expression->random->max) &&
-			       _analyzeExpression(expression->random->charset);
+			if (expression->operator == ADDITION) {
+				return _analyzeAddition(analysis, expression);
+			}
+			return _analyzeAtomicExpression(analysis, expression->operands[0]) &&
+				   _analyzeAtomicExpression(analysis, expression->operands[1]);
+		case EXPRESSION_ECP:
+			return _analyzeExpression(analysis, expression->operands[0]) &&
+				   _analyzeExpression(analysis, expression->operands[1]);
 		case EXPRESSION_REV:
 		case EXPRESSION_TUP:
 		case EXPRESSION_TLO:
 		case EXPRESSION_LEN:
-			return _analyzeExpression(expression->unary->input);
+			return _analyzeExpression(analysis, expression->operands[0]);
+		case EXPRESSION_RND:
 		case EXPRESSION_RPL:
-			return _analyzeExpression(expression->replace->original) &&
-			       _analyzeExpression(expression->replace->target) &&
-			       _analyzeExpression(expression->replace->replacement);
-		case EXPRESSION_ECP:
-			return _analyzeExpression(expression->binary->input) &&
-				   _analyzeExpression(expression->binary->key);
+			return _analyzeExpression(analysis, expression->operands[0]) &&
+			       _analyzeExpression(analysis, expression->operands[1]) &&
+			       _analyzeExpression(analysis, expression->operands[2]);
+		case EXPRESSION_MRP:
+			return _analyzeExpression(analysis, expression->operands[0]) &&
+			       _analyzeExpression(analysis, expression->operands[1]);
+		case REPLACEMENT_EXPRESSION:
+			return _analyzeExpression(analysis, expression->operands[0]) &&
+			       _analyzeExpression(analysis, expression->operands[1]) &&
+			       (expression->operands[2] == NO_EXPRESSION || _analyzeExpression(analysis, expression->operands[2]));
 
 		default:
 			logError(_logger, "Unknown expression type.");
@@ -152,44 +207,51 @@ static boolean _analyzeExpression(Expression* expression) {
 	}
 }
 
-static boolean _analyzeFactor(Factor* factor) {
-    _logSemanticAnalizer(__FUNCTION__);
+/**
+ * Like "_analyzeExpression", but the value must be atomic (the operands of
+ * the arithmetic, and the value of the "Atomic" declarations).
+ */
+static boolean _analyzeAtomicExpression(SemanticAnalysis* analysis, ExpressionId id) {
+	if (!_analyzeExpression(analysis, id)) { return false; }
 
-	if (!factor) { return false; }
+	if (analysis->expressions[id].valueType != ATOMIC_TYPE) {
+		logError(_logger, "An atomic value was expected, but a string was found.");
+		return false;
+	}
+	return true;
+}
 
-	switch (factor->type) {
-		case CONSTANT_FACTOR:
-			return true;
-		case EXPRESSION_FACTOR:
-			return _analyzeExpression(factor->expression);
-		case INTERPOLATION_FACTOR:
-			return _analyzeInterpolation(factor->interpolation);
-        case IDENTIFIER_FACTOR:
-            return _analyzeIdentifierFactor(factor);
-		default:
-			logError(_logger, "Unknown factor type.");
-			return false;
+/**
+ * An addition of atomic values, or the concatenation of its operands if any
+ * of them is a string (then the atomic one is converted).
+ */
+static boolean _analyzeAddition(SemanticAnalysis* analysis, Expression* expression) {
+	const ExpressionId left = expression->operands[0];
+	const ExpressionId right = expression->operands[1];
+
+	if (!_analyzeExpression(analysis, left) || !_analyzeExpression(analysis, right)) { return false; }
+
+	if (analysis->expressions[left].valueType == STRING_TYPE || analysis->expressions[right].valueType == STRING_TYPE) {
+		expression->valueType = STRING_TYPE;
 	}
+	return true;
 }
 
-static boolean _analyzeInterpolation(Interpolation* interpolation) {
+static boolean _analyzeInterpolation(SemanticAnalysis* analysis, Interpolation* interpolation) {
     _logSemanticAnalizer(__FUNCTION__);
 
 	if (!interpolation || !interpolation->fragments) { return true; }
 
-	InterpolationFragment* current = interpolation->fragments->head;
-
-	while (current != NULL) {
-		if (!_analyzeInterpolationFragment(current)) {
+	for (InterpolationFragmentList* current = interpolation->fragments; current != NULL; current = current->next) {
+		if (!_analyzeInterpolationFragment(analysis, current->head)) {
 			return false;
 		}
-        current = current->next;
 	}
 
 	return true;
 }
 
-static boolean _analyzeInterpolationFragment(InterpolationFragment* fragment) {
+static boolean _analyzeInterpolationFragment(SemanticAnalysis* analysis, InterpolationFragment* fragment) {
     _logSemanticAnalizer(__FUNCTION__);
 
 	if (!fragment) { return false; }
@@ -201,16 +263,18 @@ static boolean _analyzeInterpolationFragment(InterpolationFragment* fragment) {
 		case EXPRESSION_FRAGMENT: {
 			char* identifier = fragment->identifier;
 
-			if (!isSymbolDefined(_symbolTable, identifier)) {
+            Symbol *symbol = getSymbol(analysis->symbolTable, identifier);
+
+			if (!symbol) {
 				logError(_logger, "Undefined identifier in interpolation: '%s'", identifier);
 				return false;
 			}
-            Symbol *symbol = getSymbol(_symbolTable, identifier);
 			SymbolKind kind = symbol->kind;
 
 			if (kind != VARIABLE_SYMBOL || symbol->variable.type == BUFFER_TYPE) {
 				logWarning(_logger, "This type of interpolating is still not supported '%s'", identifier); // En este caso no considero que deba quedar en error
 			}
+			fragment->slot = symbol->slot;
 
 			return true;
 		}
@@ -221,31 +285,33 @@ static boolean _analyzeInterpolationFragment(InterpolationFragment* fragment) {
 	}
 }
 
-static boolean _analyzeIdentifierFactor(Factor* factor) {
-    if (!factor || !factor->identifier) { return false; }
+static boolean _analyzeIdentifier(SemanticAnalysis* analysis, Expression* expression) {
+    char* identifier = expression->identifier;
+    if (!identifier) { return false; }
 
-    char* identifier = factor->identifier;
+    Symbol* symbol = getSymbol(analysis->symbolTable, identifier);
 
-    if (!isSymbolDefined(_symbolTable, identifier)) {
+    if (!symbol) {
         logError(_logger, "Undefined identifier: '%s'", identifier);
         return false;
     }
 
-    Symbol* symbol = getSymbol(_symbolTable, identifier);
-
     if (symbol->kind != VARIABLE_SYMBOL && symbol->kind != ROUTINE_SYMBOL) {
         logError(_logger, "Identifier '%s' must be a variable or routine.", identifier);
         return false;
     }
 
+    expression->slot = symbol->slot;
+    if (symbol->kind == VARIABLE_SYMBOL && symbol->variable.type == ATOMIC_TYPE) {
+        expression->valueType = ATOMIC_TYPE;
+    }
+
     return true;
 }
 
 //--------------------------------------------------------------------------
 
 boolean performSemanticAnalysis(Program* program, SymbolTable* symbolTable) {
-    _initializeSemanticAnalyzerModule(symbolTable);
-
     _logSemanticAnalizer(__FUNCTION__);
     boolean status = false;
 
@@ -255,10 +321,20 @@ boolean performSemanticAnalysis(Program* program, SymbolTable* symbolTable) {
 		status = true;
 	}
     else {
-        status = _analyzeStatementList(program->statements);
+        SemanticAnalysis analysis = {
+            .symbolTable = symbolTable,
+            .expressions = program->expressions ? program->expressions->expressions : NULL
+        };
+        status = _analyzeStatementList(&analysis, program->statements);
     }
     
-    _shutdownSemanticAnalyzerModule();
-
     return status;
-}
\ No newline at end of file
+}
+
+boolean performStatementAnalysis(Statement* statement, const ExpressionPool* expressions, SymbolTable* symbolTable) {
+    SemanticAnalysis analysis = {
+        .symbolTable = symbolTable,
+        .expressions = expressions->expressions
+    };
+    return _analyzeStatement(&analysis, statement);
+}
@@ -8,6 +8,23 @@
 
 // ------------------------------------------------------------------------------------
 
+/** Initialize module's internal state. */
+void initializeSemanticAnalyzerModule();
+
+/** Shutdown module's internal state. */
+void shutdownSemanticAnalyzerModule();
+
+/**
+ * Checks a program, and defines its symbols in the table. The analysis keeps
+ * no global state, so many programs can be analyzed at the same time (each
+ * one with its own table).
+ */
 boolean performSemanticAnalysis(Program* program, SymbolTable* symbolTable);
 
+/**
+ * Checks a single top-level statement of a streamed program, and defines its
+ * symbols in the table (shared with the previous statements).
+ */
+boolean performStatementAnalysis(Statement* statement, const ExpressionPool* expressions, SymbolTable* symbolTable);
+
 #endif
\ No newline at end of file
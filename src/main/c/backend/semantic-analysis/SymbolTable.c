@@ -1,45 +1,159 @@
 #include "SymbolTable.h"
 
-#define INITIAL_CAPACITY        64
+#define INITIAL_INDEX_CAPACITY      128
+#define PAGE_SHIFT                  8
+#define PAGE_SIZE                   (1 << PAGE_SHIFT)
+#define PAGE_MASK                   (PAGE_SIZE - 1)
 
 static Logger* _logger = NULL;
 
+/**
+ * A bucket of the open-addressing index. The hash of the name is cached, so
+ * most of the probes never touch the symbol itself. The names are interned,
+ * hence the hash is computed over their address, not their characters.
+ */
+typedef struct {
+    uint32_t hash;
+    int position;
+} IndexEntry;
+
+/**
+ * The symbols are stored in fixed-size pages (in definition order), so a
+ * pointer to a symbol remains valid while the table grows.
+ */
 struct SymbolTable {
-    Symbol* entries;
+    Symbol** pages;
+    int pageCount;
+    int pageCapacity;
     int size;
-    int capacity;
+
+    IndexEntry* index;
+    int indexCapacity;
 };
 
 //--------------------------------------------------------------------------------
 
-static void expand(SymbolTable* table) {
-    table->capacity *= 2;
-    table->entries = realloc(table->entries, sizeof(Symbol) * table->capacity);
-    // Acá ya asumo que funca siempre (TODO: validar realloc)
-}
-
 static void _logSymbolTable(const char* functionName) {
 	logDebugging(_logger, "%s", functionName);
 }
 
+/**
+ * Fibonacci hashing of the address of an interned name.
+ *
+ * @see https://en.wikipedia.org/wiki/Hash_function#Fibonacci_hashing
+ */
+static uint32_t _hash(const char* name) {
+    return (uint32_t) (((uint64_t) (uintptr_t) name * 11400714819323198485ull) >> 32);
+}
+
+static Symbol* _symbolAt(SymbolTable* table, int position) {
+    return &table->pages[position >> PAGE_SHIFT][position & PAGE_MASK];
+}
+
+/**
+ * Finds the bucket of a name: the one that holds it, or the empty bucket
+ * where it should be inserted.
+ */
+static IndexEntry* _probe(SymbolTable* table, const char* name, uint32_t hash) {
+    const int mask = table->indexCapacity - 1;
+
+    for (int k = hash & mask; ; k = (k + 1) & mask) {
+        IndexEntry* entry = &table->index[k];
+
+        if (entry->position < 0) { return entry; }
+        if (entry->hash == hash && _symbolAt(table, entry->position)->name == name) {
+            return entry;
+        }
+    }
+}
+
+/**
+ * Doubles the capacity of the index, keeping the load factor under 1/2.
+ */
+static boolean _expandIndex(SymbolTable* table) {
+    IndexEntry* oldIndex = table->index;
+    const int oldCapacity = table->indexCapacity;
+    IndexEntry* index = malloc(sizeof(IndexEntry) * oldCapacity * 2);
+
+    if (!index) { return false; }
+
+    table->index = index;
+    table->indexCapacity = oldCapacity * 2;
+    for (int k = 0; k < table->indexCapacity; ++k) {
+        table->index[k].position = -1;
+    }
+
+    const int mask = table->indexCapacity - 1;
+    for (int k = 0; k < oldCapacity; ++k) {
+        if (oldIndex[k].position < 0) { continue; }
+
+        int bucket = oldIndex[k].hash & mask;
+        while (table->index[bucket].position >= 0) {
+            bucket = (bucket + 1) & mask;
+        }
+        table->index[bucket] = oldIndex[k];
+    }
+
+    free(oldIndex);
+    return true;
+}
+
+/**
+ * Reserves the storage for the next symbol. Only the page directory gets
+ * reallocated, never the pages themselves.
+ */
+static Symbol* _nextSymbol(SymbolTable* table) {
+    const int page = table->size >> PAGE_SHIFT;
+
+    if (page == table->pageCount) {
+        if (table->pageCount == table->pageCapacity) {
+            Symbol** pages = realloc(table->pages, sizeof(Symbol*) * table->pageCapacity * 2);
+            if (!pages) { return NULL; }
+            table->pages = pages;
+            table->pageCapacity *= 2;
+        }
+
+        table->pages[page] = malloc(sizeof(Symbol) * PAGE_SIZE);
+        if (!table->pages[page]) { return NULL; }
+        table->pageCount++;
+    }
+
+    return _symbolAt(table, table->size);
+}
+
 //--------------------------------------------------------------------------------
 
-SymbolTable* createSymbolTable() {
-    if (!_logger) { _logger = createLogger("SymbolTable"); }
+void initializeSymbolTableModule() {
+    _logger = createLogger("SymbolTable");
+}
+
+void shutdownSymbolTableModule() {
+    if (_logger != NULL) {
+        destroyLogger(_logger);
+    }
+}
 
+SymbolTable* createSymbolTable() {
     _logSymbolTable(__FUNCTION__);
 
-    SymbolTable* table = malloc(sizeof(SymbolTable));
+    SymbolTable* table = calloc(1, sizeof(SymbolTable));
 
     if (!table) { return NULL; }
-    table->entries = malloc(sizeof(Symbol) * INITIAL_CAPACITY);
-
-    if (!table->entries) {
-        free (table);
+    table->pageCapacity = 4;
+    table->pages = malloc(sizeof(Symbol*) * table->pageCapacity);
+    table->indexCapacity = INITIAL_INDEX_CAPACITY;
+    table->index = malloc(sizeof(IndexEntry) * table->indexCapacity);
+
+    if (!table->pages || !table->index) {
+        free(table->pages);
+        free(table->index);
+        free(table);
         return NULL;
     }
-    table->size = 0;
-    table->capacity = INITIAL_CAPACITY;
+
+    for (int k = 0; k < table->indexCapacity; ++k) {
+        table->index[k].position = -1;
+    }
 
     return table;
 }
@@ -47,12 +161,6 @@ SymbolTable* createSymbolTable() {
 void destroySymbol(Symbol* symbol) {
 	if (!symbol || !symbol->name) { return; }
 
-	free(symbol->name);
-
-	if (symbol->kind == VARIABLE_SYMBOL && symbol->variable.type == STRING_TYPE && symbol->variable.stringValue) {
-		free(symbol->variable.stringValue);
-	}
-
 	symbol->name = NULL;
 }
 
@@ -62,70 +170,69 @@ void destroySymbolTable(SymbolTable* table) {
     if (!table) { return; }
 
     for (int i = 0; i < table->size; i++) {
-        destroySymbol(&table->entries[i]);
+        destroySymbol(_symbolAt(table, i));
     }
 
-    free(table->entries);
+    for (int k = 0; k < table->pageCount; ++k) {
+        free(table->pages[k]);
+    }
+
+    free(table->pages);
+    free(table->index);
     free(table);
 }
 
 //--------------------------------------------------------------------------------
 
-boolean defineSymbol(SymbolTable* table, char* name, Symbol symbol) {
+boolean defineSymbol(SymbolTable* table, char* name, Symbol* symbol) {
     _logSymbolTable(__FUNCTION__);
 
-    if (!table || !name) { return false; }
-    if (isSymbolDefined(table, name)) { return false; }
+    if (!table || !name || !symbol) { return false; }
 
-    if (table->size >= table->capacity) {
-        expand(table);
+    if (2 * (table->size + 1) > table->indexCapacity && !_expandIndex(table)) {
+        return false;
     }
 
-    char* copiedName = strdup(name);
-    if (!copiedName) { return false; }
+    const uint32_t hash = _hash(name);
+    IndexEntry* entry = _probe(table, name, hash);
+
+    if (entry->position >= 0) { return false; }
 
-    symbol.name = copiedName;
-    table->entries[table->size++] = symbol;
+    Symbol* storage = _nextSymbol(table);
+    if (!storage) { return false; }
+
+    symbol->name = name;
+    symbol->slot = table->size;
+    *storage = *symbol;
+
+    entry->hash = hash;
+    entry->position = table->size++;
 
     return true;
 }
 
 boolean isSymbolDefined(SymbolTable* table, char* name) {
-    _logSymbolTable(__FUNCTION__);
-    
-    if (!table || !name) { return false; }
-
-    for (int i = 0; i < table->size; i++) {
-        if (strcmp(table->entries[i].name, name) == 0) {
-            return true;
-        }
-    }
-
-    return false;
+    return getSymbol(table, name) != NULL;
 }
 
 Symbol* getSymbol(SymbolTable* table, char* name) {
     _logSymbolTable(__FUNCTION__);
-    
+
     if (!table || !name) { return NULL; }
 
-    for (int i = 0; i < table->size; i++) {
-        if (strcmp(table->entries[i].name, name) == 0) {
-            return &table->entries[i];
-        }
-    }
+    IndexEntry* entry = _probe(table, name, _hash(name));
 
-    return NULL;
+    return entry->position < 0 ? NULL : _symbolAt(table, entry->position);
 }
 
-boolean setSymbolValue(SymbolTable* table, char* name, VariableData value) {
-    _logSymbolTable(__FUNCTION__);
+Symbol* getSymbolAt(SymbolTable* table, int position) {
+    if (!table || position < 0 || table->size <= position) { return NULL; }
 
-	Symbol* symbol = getSymbol(table, name);
-	
-    if (!symbol || symbol->kind != VARIABLE_SYMBOL) { return false; }
+    return _symbolAt(table, position);
+}
 
-	symbol->variable = value;
+int getSymbolCount(SymbolTable* table) {
+    if (!table) { return 0; }
 
-	return true;
+    return table->size;
 }
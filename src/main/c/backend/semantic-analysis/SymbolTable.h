@@ -12,35 +12,45 @@ typedef enum {
 	ROUTINE_SYMBOL
 } SymbolKind;
 
+// The values live in the slots of the virtual machine, not in the table.
 typedef struct {
 	ConstantType type;
-	union
-	{
-		char* stringValue;
-		int atomicValue;
-	};
-	
 } VariableData;
 
 typedef struct {
     char* name;
 	SymbolKind kind;
 
+	// The definition order of the symbol, used as its runtime slot.
+	int slot;
+
 	union {
 		VariableData variable;
 	    Routine* routine;
 	};
 } Symbol;
 
+/**
+ * The names of the symbols must be interned (see "Interner.h"): they are
+ * compared by identity, and the table doesn't copy them.
+ */
 typedef struct SymbolTable SymbolTable;
 
+/** Initialize module's internal state. */
+void initializeSymbolTableModule();
+
+/** Shutdown module's internal state. */
+void shutdownSymbolTableModule();
+
 SymbolTable* createSymbolTable();
 void destroySymbol(Symbol* symbol);
 void destroySymbolTable(SymbolTable* table);
 
-boolean defineVariableSymbol(SymbolTable* table, char* name, Symbol symbol);
+boolean defineSymbol(SymbolTable* table, char* name, Symbol* symbol);
 boolean isSymbolDefined(SymbolTable* table, char* name);
 Symbol* getSymbol(SymbolTable* table, char* name);
-boolean setSymbolValue(SymbolTable* table, char* name, VariableData value);
+// Symbols are kept in definition order, and pointers to them remain valid.
+Symbol* getSymbolAt(SymbolTable* table, int position);
+int getSymbolCount(SymbolTable* table);
 
 #endif
\ No newline at end of file
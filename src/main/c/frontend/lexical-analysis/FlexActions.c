@@ -18,13 +18,31 @@ void shutdownFlexActionsModule() {
 
 /* PRIVATE FUNCTIONS */
 
+static char * _internLexeme(LexicalAnalyzerContext * lexicalAnalyzerContext, const char * lexeme, const size_t length);
 static void _logLexicalAnalyzerContext(const char * functionName, LexicalAnalyzerContext * lexicalAnalyzerContext);
 
+/**
+ * Interns a lexeme in the compilation of the context, so every occurrence of
+ * the same identifier or literal shares a single copy. Interned strings are
+ * read-only. Returns NULL if the system runs out of memory.
+ */
+static char * _internLexeme(LexicalAnalyzerContext * lexicalAnalyzerContext, const char * lexeme, const size_t length) {
+	char * string = (char *) intern(lexicalAnalyzerContext->compilerState->interner, lexeme, length);
+	if (string == NULL) {
+		logError(_logger, "Cannot intern the lexeme in line %d.", lexicalAnalyzerContext->line);
+	}
+	return string;
+}
+
 /**
  * Logs a lexical-analyzer context in DEBUGGING level.
  */
 static void _logLexicalAnalyzerContext(const char * functionName, LexicalAnalyzerContext * lexicalAnalyzerContext) {
-	char * escapedLexeme = escape(lexicalAnalyzerContext->lexeme);
+	// Avoids the escaped copy of every lexeme when it would never be logged.
+	if (!isLoggable(_logger, DEBUGGING)) {
+		return;
+	}
+	char * escapedLexeme = escapeSubstring(lexicalAnalyzerContext->lexeme, lexicalAnalyzerContext->length);
 	logDebugging(_logger, "%s: %s (context = %d, length = %d, line = %d)",
 		functionName,
 		escapedLexeme,
@@ -54,11 +72,14 @@ void IgnoredLexemeAction(LexicalAnalyzerContext * lexicalAnalyzerContext) {
 	}
 }
 
+void EndOfFileLexemeAction(LexicalAnalyzerContext * lexicalAnalyzerContext) {
+	logDebugging(_logger, "%s: EOF, popping buffer (line = %d).", __FUNCTION__, lexicalAnalyzerContext->line);
+}
+
 Token TypeLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext, Token token) {
 	_logLexicalAnalyzerContext(__FUNCTION__, lexicalAnalyzerContext);
 
 	lexicalAnalyzerContext->semanticValue->token = token;
-	destroyLexicalAnalyzerContext(lexicalAnalyzerContext);
 
 	return token;
 }
@@ -67,7 +88,6 @@ Token KeywordLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext, Token
 	_logLexicalAnalyzerContext(__FUNCTION__, lexicalAnalyzerContext);
 
 	lexicalAnalyzerContext->semanticValue->token = token;
-	destroyLexicalAnalyzerContext(lexicalAnalyzerContext);
 
 	return token;
 }
@@ -76,7 +96,6 @@ Token SymbolLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext, Token t
 	_logLexicalAnalyzerContext(__FUNCTION__, lexicalAnalyzerContext);
 
 	lexicalAnalyzerContext->semanticValue->token = token;
-	destroyLexicalAnalyzerContext(lexicalAnalyzerContext);
 
 	return token;
 }
@@ -84,8 +103,16 @@ Token SymbolLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext, Token t
 Token AtomicLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext, Token token) {
 	_logLexicalAnalyzerContext(__FUNCTION__, lexicalAnalyzerContext);
 
-	lexicalAnalyzerContext->semanticValue->atomic = atoi(lexicalAnalyzerContext->lexeme);
-	destroyLexicalAnalyzerContext(lexicalAnalyzerContext);
+	int64_t atomic = 0;
+	for (unsigned int k = 0; k < lexicalAnalyzerContext->length; ++k) {
+		const int digit = lexicalAnalyzerContext->lexeme[k] - '0';
+		if ((INT64_MAX - digit) / 10 < atomic) {
+			logError(_logger, "The atomic literal in line %d is out of range.", lexicalAnalyzerContext->line);
+			return UNKNOWN;
+		}
+		atomic = 10 * atomic + digit;
+	}
+	lexicalAnalyzerContext->semanticValue->atomic = atomic;
 
 	return token;
 }
@@ -93,8 +120,10 @@ Token AtomicLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext, Token t
 Token StringLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext, Token token) {
 	_logLexicalAnalyzerContext(__FUNCTION__, lexicalAnalyzerContext);
 
-	lexicalAnalyzerContext->semanticValue->string = strdup(lexicalAnalyzerContext->lexeme);
-	destroyLexicalAnalyzerContext(lexicalAnalyzerContext);
+	lexicalAnalyzerContext->semanticValue->string = _internLexeme(lexicalAnalyzerContext, lexicalAnalyzerContext->lexeme, lexicalAnalyzerContext->length);
+	if (lexicalAnalyzerContext->semanticValue->string == NULL) {
+		return UNKNOWN;
+	}
 
 	return token;
 }
@@ -102,8 +131,10 @@ Token StringLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext, Token t
 Token IdentifierLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext) {
 	_logLexicalAnalyzerContext(__FUNCTION__, lexicalAnalyzerContext);
 	
-	lexicalAnalyzerContext->semanticValue->string = strdup(lexicalAnalyzerContext->lexeme);
-	destroyLexicalAnalyzerContext(lexicalAnalyzerContext);
+	lexicalAnalyzerContext->semanticValue->string = _internLexeme(lexicalAnalyzerContext, lexicalAnalyzerContext->lexeme, lexicalAnalyzerContext->length);
+	if (lexicalAnalyzerContext->semanticValue->string == NULL) {
+		return UNKNOWN;
+	}
 
 	return IDENTIFIER_TOKEN;
 }
@@ -112,25 +143,16 @@ Token InterpolatedIdentifierLexemeAction(LexicalAnalyzerContext* lexicalAnalyzer
     _logLexicalAnalyzerContext(__FUNCTION__, lexicalAnalyzerContext);
 
     const char* lexeme = lexicalAnalyzerContext->lexeme;
-    size_t len = strlen(lexeme);
+    size_t len = lexicalAnalyzerContext->length;
 
     if (len >= 4 && lexeme[0] == '$' && lexeme[1] == '{' && lexeme[len - 1] == '}') {
-        size_t contentLen = len - 3;
-        char* content = malloc(contentLen + 1);
-		
-        if (!content) {
-            destroyLexicalAnalyzerContext(lexicalAnalyzerContext);
-            return UNKNOWN;
-        }
-        strncpy(content, lexeme + 2, contentLen);
-        content[contentLen] = '\0';
-
-        lexicalAnalyzerContext->semanticValue->string = content;
+        lexicalAnalyzerContext->semanticValue->string = _internLexeme(lexicalAnalyzerContext, lexeme + 2, len - 3);
     } else {
-        lexicalAnalyzerContext->semanticValue->string = strdup(lexeme);
+        lexicalAnalyzerContext->semanticValue->string = _internLexeme(lexicalAnalyzerContext, lexeme, len);
+    }
+    if (lexicalAnalyzerContext->semanticValue->string == NULL) {
+        return UNKNOWN;
     }
-	// logDebugging(_logger, lexicalAnalyzerContext->semanticValue->string);
-    destroyLexicalAnalyzerContext(lexicalAnalyzerContext);
 
     return INTERPOLATED_IDENTIFIER_TOKEN;
 }
@@ -138,15 +160,13 @@ Token InterpolatedIdentifierLexemeAction(LexicalAnalyzerContext* lexicalAnalyzer
 Token RoutineCallLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext) {
 	_logLexicalAnalyzerContext(__FUNCTION__, lexicalAnalyzerContext);
 
-	char* lexeme = lexicalAnalyzerContext->lexeme;
-	size_t len = strlen(lexeme);
-	char* identifier = strdup(lexeme);
-	
-	if (len) { identifier[len-1] = '\0'; }
-
-	lexicalAnalyzerContext->semanticValue->string = identifier;
+	size_t len = lexicalAnalyzerContext->length;
 
-	destroyLexicalAnalyzerContext(lexicalAnalyzerContext);
+	// Drops the trailing "!" of the call.
+	lexicalAnalyzerContext->semanticValue->string = _internLexeme(lexicalAnalyzerContext, lexicalAnalyzerContext->lexeme, len ? len - 1 : 0);
+	if (lexicalAnalyzerContext->semanticValue->string == NULL) {
+		return UNKNOWN;
+	}
 
 	return ROUTINE_CALL_TOKEN;
 }
@@ -154,8 +174,6 @@ Token RoutineCallLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext) {
 Token UnknownLexemeAction(LexicalAnalyzerContext * lexicalAnalyzerContext) {
 	_logLexicalAnalyzerContext(__FUNCTION__, lexicalAnalyzerContext);
 
-	destroyLexicalAnalyzerContext(lexicalAnalyzerContext);
-
 	return UNKNOWN;
 }
 
@@ -6,6 +6,7 @@
 #include "../../shared/String.h"  
 #include "../../shared/Type.h"  
 #include "../syntactic-analysis/AbstractSyntaxTree.h"
+#include "../syntactic-analysis/SyntacticAnalyzer.h"
 #include "../syntactic-analysis/BisonParser.h"
 #include "LexicalAnalyzerContext.h"  
 #include <stdio.h>  
@@ -25,6 +26,7 @@ void shutdownFlexActionsModule();
 void BeginMultilineCommentLexemeAction(LexicalAnalyzerContext * lexicalAnalyzerContext);
 void EndMultilineCommentLexemeAction(LexicalAnalyzerContext * lexicalAnalyzerContext);
 void IgnoredLexemeAction(LexicalAnalyzerContext * lexicalAnalyzerContext);
+void EndOfFileLexemeAction(LexicalAnalyzerContext * lexicalAnalyzerContext);
 
 Token TypeLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext, Token token);  
 Token KeywordLexemeAction(LexicalAnalyzerContext* lexicalAnalyzerContext, Token token);
@@ -4,9 +4,10 @@
 /**
  * Hook that allows to export a static function or variable from the inside of
  * Flex infrastructure, in this case, the current context (a.k.a. start
- * condition).
+ * condition) of a scanner.
  */
-unsigned int flexCurrentContext(void) {
+unsigned int flexCurrentContext(yyscan_t yyscanner) {
+	struct yyguts_t * yyg = (struct yyguts_t *) yyscanner;
 	return YY_START;
 }
 
@@ -1,44 +1,40 @@
 #include "LexicalAnalyzerContext.h"
 
 /**
- * Flex exported variables and functions.
+ * Flex exported functions. The scanner is reentrant, so its state is read
+ * through accessors.
  *
- * @see https://westes.github.io/flex/manual/User-Values.html
+ * @see https://westes.github.io/flex/manual/Accessor-Methods.html
  */
 
 // The wrapper of "yy_top_state" function (provided by Flex).
-extern unsigned int flexCurrentContext(void);
+extern unsigned int flexCurrentContext(void * scanner);
+
+// The compiler state of the compilation (provided by Flex).
+extern CompilerState * yyget_extra(void * scanner);
 
 // The lexeme length in characters (provided by Flex).
-extern int yyleng;
+extern int yyget_leng(void * scanner);
 
 // The line number (provided by Flex).
-extern int yylineno;
+extern int yyget_lineno(void * scanner);
 
 // The semantic value of the lookahead symbol (provided by Bison).
-extern union SemanticValue yylval;
+extern union SemanticValue * yyget_lval(void * scanner);
 
 // The current lexeme (provided by Flex).
-extern char * yytext;
+extern char * yyget_text(void * scanner);
 
 /* PUBLIC FUNCTIONS */
 
-LexicalAnalyzerContext * createLexicalAnalyzerContext() {
-	LexicalAnalyzerContext * lexicalAnalyzerContext = calloc(1, sizeof(LexicalAnalyzerContext));
-	lexicalAnalyzerContext->length = yyleng;
-	lexicalAnalyzerContext->lexeme = calloc(1 + yyleng, sizeof(char));
-	lexicalAnalyzerContext->line = yylineno;
-	lexicalAnalyzerContext->semanticValue = &yylval;
-	lexicalAnalyzerContext->currentContext = flexCurrentContext();
-	strncpy(lexicalAnalyzerContext->lexeme, yytext, yyleng);
+LexicalAnalyzerContext createLexicalAnalyzerContext(void * scanner) {
+	LexicalAnalyzerContext lexicalAnalyzerContext = {
+		.compilerState = yyget_extra(scanner),
+		.currentContext = flexCurrentContext(scanner),
+		.length = yyget_leng(scanner),
+		.lexeme = yyget_text(scanner),
+		.line = yyget_lineno(scanner),
+		.semanticValue = yyget_lval(scanner)
+	};
 	return lexicalAnalyzerContext;
 }
-
-void destroyLexicalAnalyzerContext(LexicalAnalyzerContext * lexicalAnalyzerContext) {
-	if (lexicalAnalyzerContext != NULL) {
-		if (lexicalAnalyzerContext->lexeme != NULL) {
-			free(lexicalAnalyzerContext->lexeme);
-		}
-		free(lexicalAnalyzerContext);
-	}
-}
@@ -1,30 +1,28 @@
 #ifndef LEXICAL_ANALYZER_CONTEXT_HEADER
 #define LEXICAL_ANALYZER_CONTEXT_HEADER
 
+#include "../../shared/CompilerState.h"
 #include <stdlib.h>
 #include <string.h>
 
 /**
- * The state of a lexical-analyzer context.
+ * The state of a lexical-analyzer context. The lexeme is a slice of the
+ * input buffer (it's not null-terminated, and it's only valid during the
+ * action that consumes it), so creating a context never allocates memory.
  */
 typedef struct {
+	CompilerState * compilerState;
 	unsigned int currentContext;
 	unsigned int length;
-	char * lexeme;
+	const char * lexeme;
 	unsigned int line;
 	union SemanticValue * semanticValue;
 } LexicalAnalyzerContext;
 
 /**
- * Creates a new context with the current state of the lexical-analyzer over
- * the lexeme just consumed. The lexeme is a deep-copy of the original,
- * allocated in heap-memory.
+ * Creates a new context with the current state of a scanner (a "yyscan_t")
+ * over the lexeme just consumed.
  */
-LexicalAnalyzerContext * createLexicalAnalyzerContext();
-
-/**
- * Destroy a lexical-analyzer context and its resources.
- */
-void destroyLexicalAnalyzerContext(LexicalAnalyzerContext * lexicalAnalyzerContext);
+LexicalAnalyzerContext createLexicalAnalyzerContext(void * scanner);
 
 #endif
@@ -0,0 +1,194 @@
+#include "SourceInput.h"
+
+#define INITIAL_READ_CAPACITY			(1024 * 1024)
+
+/* MODULE INTERNAL STATE */
+
+static Logger * _logger = NULL;
+
+void initializeSourceInputModule() {
+	_logger = createLogger("SourceInput");
+}
+
+void shutdownSourceInputModule() {
+	if (_logger != NULL) {
+		destroyLogger(_logger);
+	}
+}
+
+/* PRIVATE FUNCTIONS */
+
+#ifdef MEMORY_MAPPED_INPUT
+static boolean _mapFile(SourceInput * sourceInput, const int descriptor, const size_t length);
+#endif
+static boolean _readStream(SourceInput * sourceInput, FILE * stream);
+
+#ifdef MEMORY_MAPPED_INPUT
+/**
+ * Maps a regular file in private (copy-on-write) mode, because Flex writes
+ * over the buffer while scanning. A zeroed region is reserved first, and then
+ * the file is mapped over it: the end-of-buffer marker falls either in the
+ * zero-filled tail of the last page of the file, or in the reserved page that
+ * follows it.
+ */
+static boolean _mapFile(SourceInput * sourceInput, const int descriptor, const size_t length) {
+	const size_t pageSize = sysconf(_SC_PAGESIZE);
+	const size_t capacity = (length + END_OF_BUFFER_MARKER_LENGTH + pageSize - 1) & ~(pageSize - 1);
+
+	char * reservation = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (reservation == MAP_FAILED) {
+		return false;
+	}
+	char * buffer = mmap(reservation, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, descriptor, 0);
+	if (buffer == MAP_FAILED) {
+		munmap(reservation, capacity);
+		return false;
+	}
+	madvise(buffer, length, MADV_SEQUENTIAL);
+
+	sourceInput->buffer = buffer;
+	sourceInput->length = length;
+	sourceInput->capacity = capacity;
+	sourceInput->mapped = true;
+	return true;
+}
+#endif
+
+/**
+ * Reads a stream until its end in large blocks, doubling the buffer when it
+ * gets full. Used for pipes, terminals, and when the mapping is unavailable.
+ */
+static boolean _readStream(SourceInput * sourceInput, FILE * stream) {
+	size_t capacity = INITIAL_READ_CAPACITY;
+	size_t length = 0;
+	char * buffer = malloc(capacity);
+
+	while (buffer != NULL) {
+		if (capacity - length <= END_OF_BUFFER_MARKER_LENGTH) {
+			char * expandedBuffer = realloc(buffer, 2 * capacity);
+			if (expandedBuffer == NULL) {
+				break;
+			}
+			buffer = expandedBuffer;
+			capacity *= 2;
+		}
+		const size_t bytes = fread(buffer + length, 1, capacity - length - END_OF_BUFFER_MARKER_LENGTH, stream);
+		length += bytes;
+		if (bytes == 0) {
+			if (ferror(stream)) {
+				break;
+			}
+			memset(buffer + length, '\0', END_OF_BUFFER_MARKER_LENGTH);
+			sourceInput->buffer = buffer;
+			sourceInput->length = length;
+			sourceInput->capacity = capacity;
+			sourceInput->mapped = false;
+			return true;
+		}
+	}
+
+	free(buffer);
+	return false;
+}
+
+/* PUBLIC FUNCTIONS */
+
+SourceInput * openSourceInput(const char * path, const boolean streamed) {
+	const char * name = path == NULL ? "<standard input>" : path;
+	FILE * stream = path == NULL ? stdin : fopen(path, "rb");
+	if (stream == NULL) {
+		logError(_logger, "Cannot open the program \"%s\": %s.", name, strerror(errno));
+		return NULL;
+	}
+
+	SourceInput * sourceInput = calloc(1, sizeof(SourceInput));
+	if (sourceInput == NULL) {
+		logError(_logger, "Cannot read the program \"%s\".", name);
+		if (path != NULL) {
+			fclose(stream);
+		}
+		return NULL;
+	}
+	boolean loaded = false;
+	boolean regular = false;
+#ifdef MEMORY_MAPPED_INPUT
+	// The standard input can be a regular file too (e.g., a redirection).
+	struct stat status;
+	const int descriptor = fileno(stream);
+	regular = fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode);
+	if (regular && 0 < status.st_size && lseek(descriptor, 0, SEEK_CUR) == 0) {
+		loaded = _mapFile(sourceInput, descriptor, status.st_size);
+	}
+#endif
+	if (!loaded && streamed && !regular) {
+		logDebugging(_logger, "The program \"%s\" is streamed.", name);
+		sourceInput->stream = stream;
+		return sourceInput;
+	}
+	if (!loaded) {
+		loaded = _readStream(sourceInput, stream);
+	}
+	if (path != NULL) {
+		fclose(stream);
+	}
+
+	if (!loaded) {
+		logError(_logger, "Cannot read the program \"%s\".", name);
+		closeSourceInput(sourceInput);
+		return NULL;
+	}
+
+	logDebugging(_logger, "The program \"%s\" has %zu bytes (%s).", name, sourceInput->length,
+		sourceInput->mapped ? "memory-mapped" : "read");
+	return sourceInput;
+}
+
+size_t readSourceStream(FILE * stream, char * buffer, const size_t size) {
+#ifdef UNBUFFERED_INPUT
+	ssize_t bytes;
+	do {
+		bytes = read(fileno(stream), buffer, size);
+	} while (bytes < 0 && errno == EINTR);
+	if (bytes < 0) {
+		logError(_logger, "Cannot read the program: %s.", strerror(errno));
+		return 0;
+	}
+	return bytes;
+#else
+	// Without unbuffered reads, a line is the largest block that never waits
+	// for the next one.
+	size_t length = 0;
+	int character;
+	while (length < size && (character = getc(stream)) != EOF) {
+		buffer[length++] = (char) character;
+		if (character == '\n') {
+			break;
+		}
+	}
+	return length;
+#endif
+}
+
+void closeSourceInput(SourceInput * sourceInput) {
+	if (sourceInput == NULL) {
+		return;
+	}
+	if (sourceInput->stream != NULL) {
+		if (sourceInput->stream != stdin) {
+			fclose(sourceInput->stream);
+		}
+		free(sourceInput);
+		return;
+	}
+#ifdef MEMORY_MAPPED_INPUT
+	if (sourceInput->mapped) {
+		munmap(sourceInput->buffer, sourceInput->capacity);
+	}
+	else {
+		free(sourceInput->buffer);
+	}
+#else
+	free(sourceInput->buffer);
+#endif
+	free(sourceInput);
+}
@@ -0,0 +1,77 @@
+#ifndef SOURCE_INPUT_HEADER
+#define SOURCE_INPUT_HEADER
+
+#include "../../shared/Logger.h"
+#include "../../shared/Type.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The memory mapping and the unbuffered reads are only available on POSIX
+ * systems. Otherwise, the input is always read in large blocks, and a
+ * streamed input is read line by line.
+ */
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#define MEMORY_MAPPED_INPUT
+#define UNBUFFERED_INPUT
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Flex requires two null characters at the end of a buffer scanned in place.
+#define END_OF_BUFFER_MARKER_LENGTH		2
+
+/**
+ * The whole program to compile, in a single buffer. Flex scans it in place,
+ * so the content is followed by the two null characters that Flex requires
+ * as the end-of-buffer marker. A streamed input is not loaded at all: Flex
+ * reads it from the stream, as it arrives.
+ */
+typedef struct {
+	char * buffer;
+	size_t length;
+
+	// The stream to read from, only if the input is streamed (or NULL).
+	FILE * stream;
+
+	// The size of the mapping or allocation that holds the buffer.
+	size_t capacity;
+
+	// Whether the buffer is a memory mapping of the file (or it's on the heap).
+	boolean mapped;
+} SourceInput;
+
+/** Initialize module's internal state. */
+void initializeSourceInputModule();
+
+/** Shutdown module's internal state. */
+void shutdownSourceInputModule();
+
+/**
+ * Loads the program from a file (or from the standard input if the path is
+ * NULL), ready to be scanned in place. Regular files are mapped into memory;
+ * pipes and terminals are read in large blocks, unless the input is
+ * streamed: then they are left open, to be read with "readSourceStream".
+ * Returns NULL if the input cannot be loaded.
+ */
+SourceInput * openSourceInput(const char * path, const boolean streamed);
+
+/**
+ * Reads the next bytes of a streamed input (at most the size), without
+ * waiting for more than the ones already available, so every statement can
+ * be scanned as soon as it arrives. Returns 0 at the end of the stream, or
+ * on failure.
+ */
+size_t readSourceStream(FILE * stream, char * buffer, const size_t size);
+
+/**
+ * Releases the buffer of the program. The lexemes are slices of it, so it
+ * must outlive the lexical-analysis.
+ */
+void closeSourceInput(SourceInput * sourceInput);
+
+#endif
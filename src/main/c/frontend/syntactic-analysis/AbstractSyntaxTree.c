@@ -1,5 +1,7 @@
 #include "AbstractSyntaxTree.h"
 
+#define INITIAL_EXPRESSION_CAPACITY		1024
+
 /* MODULE INTERNAL STATE */
 static Logger* _logger = NULL;
 
@@ -13,147 +15,51 @@ void shutdownAbstractSyntaxTreeModule() {
 	}
 }
 
-/** PUBLIC FUNCTIONS */
-
-// ----------------------------------------------------------------------------------------------
-
-Interpolation* createInterpolation() {
-    Interpolation* interpolation = malloc(sizeof(Interpolation));
-
-    if (!interpolation) { return NULL; }
+/* PUBLIC FUNCTIONS */
 
-    interpolation->fragments = malloc(sizeof(InterpolationFragmentList));
-
-    if (!interpolation->fragments) {
-        free(interpolation);
-        return NULL;
-    }
-
-    interpolation->fragments->head = NULL;
-    interpolation->fragments->next = NULL;
-
-    return interpolation;
-}
-
-// ----------------------------------------------------------------------------------------------
-
-void releaseFactor(Factor* factor) {
-	if (!factor) { return; }
-
-	switch (factor->type) {
-		case CONSTANT_FACTOR:
-			free(factor->constant);
-			break;
-		case EXPRESSION_FACTOR:
-			releaseExpression(factor->expression);
-			break;
-		case INTERPOLATION_FACTOR:
-			releaseInterpolation(factor->interpolation);
-			break;
+ExpressionPool* createExpressionPool() {
+	ExpressionPool* pool = calloc(1, sizeof(ExpressionPool));
+	if (pool == NULL) {
+		return NULL;
 	}
-	free(factor);
-}
-
-void releaseExpression(Expression* expression) {
-	if (!expression) { return; }
-
-	switch (expression->type) {
-		case FACTOR_EXPRESSION:
-			releaseFactor(expression->factor);
-			break;
-
-		case ARITHMETIC_EXPRESSION:
-			releaseExpression(expression->arithmetic->left);
-			releaseExpression(expression->arithmetic->right);
-			break;
-
-		case EXPRESSION_RND:
-			releaseExpression(expression->random->min);
-			releaseExpression(expression->random->max);
-			releaseExpression(expression->random->charset);
-			break;
-
-		case EXPRESSION_REV:
-		case EXPRESSION_TUP:
-		case EXPRESSION_TLO:
-		case EXPRESSION_LEN:
-			releaseExpression(expression->unary->input);
-			break;
-
-		case EXPRESSION_RPL:
-			releaseExpression(expression->replace->original);
-			releaseExpression(expression->replace->target);
-			releaseExpression(expression->replace->replacement);
-			break;
-
-		default:
-			logWarning(_logger, "releaseExpression: unhandled ExpressionType = %d", expression->type);
-			break;
+	pool->capacity = INITIAL_EXPRESSION_CAPACITY;
+	pool->expressions = malloc(pool->capacity * sizeof(Expression));
+	if (pool->expressions == NULL) {
+		free(pool);
+		return NULL;
 	}
-
-	free(expression);
+	return pool;
 }
 
-
-void releaseStatementList(StatementList* list) {
-	while (list) {
-		StatementList* next = list->next;
-		releaseStatement(list->statement);
-		free(list);
-		list = next;
+void destroyExpressionPool(ExpressionPool* pool) {
+	if (pool != NULL) {
+		free(pool->expressions);
+		free(pool);
 	}
 }
 
-void releaseStatement(Statement* statement) {
-	if (!statement) { return; }
-
-	switch (statement->type) {
-		case STATEMENT_DECLARATION:
-			free(statement->declaration->identifier);
-			free(statement->declaration);
-			break;
-		case STATEMENT_ROUTINE:
-			releaseRoutine(statement->routine);
-			break;
-		case STATEMENT_ROUTINE_CALL:
-			free(statement->routineCallName);
-			break;
-		case STATEMENT_OUTPUT | STATEMENT_EXPRESSION:
-			releaseExpression(statement->expression);
-			break;
+ExpressionId addExpression(ExpressionPool* pool, ExpressionType type, Expression** expression) {
+	if (pool->count == pool->capacity) {
+		if (NO_EXPRESSION / 2 < pool->capacity) {
+			logError(_logger, "Too many expressions (%u).", pool->count);
+			return NO_EXPRESSION;
+		}
+		Expression* expressions = realloc(pool->expressions, 2 * pool->capacity * sizeof(Expression));
+		if (expressions == NULL) {
+			return NO_EXPRESSION;
+		}
+		pool->expressions = expressions;
+		pool->capacity *= 2;
 	}
-	free(statement);
-}
-
-void releaseRoutine(Routine* routine) {
-	if (!routine) { return; }
-
-	free(routine->identifier);
-	releaseStatementList(routine->body);
-	free(routine);
-}
-
-void releaseProgram(Program* program) {
-	if (!program) { return; }
-
-	releaseStatementList(program->statements);
-	free(program);
-}
-
-void releaseInterpolationFragmentList(InterpolationFragmentList* list) {
-    InterpolationFragment* current = list->head;
-	
-    while (current) {
-        InterpolationFragment* next = current->next;
-        free(current);
-        current = next;
-    }
-    free(list);
+	const ExpressionId id = pool->count++;
+	*expression = &pool->expressions[id];
+	(*expression)->type = type;
+	(*expression)->valueType = STRING_TYPE;
+	return id;
 }
 
-void releaseInterpolation(Interpolation* interpolation) {
-	if (interpolation) {
-		releaseInterpolationFragmentList(interpolation->fragments);
-		free(interpolation);
+void truncateExpressionPool(ExpressionPool* pool, const uint32_t count) {
+	if (count < pool->count) {
+		pool->count = count;
 	}
 }
@@ -19,14 +19,12 @@ typedef enum ExpressionType ExpressionType;
 typedef enum DeclarationType DeclarationType;
 typedef enum ArithmeticOperator ArithmeticOperator;
 typedef enum ConstantType ConstantType;
-typedef enum FactorType FactorType;
 typedef enum StatementType StatementType;
 typedef enum InterpolationFragmentType InterpolationFragmentType;
 
 typedef struct Buffer Buffer;
-typedef struct Constant Constant;
 typedef struct Expression Expression;
-typedef struct Factor Factor;
+typedef struct ExpressionPool ExpressionPool;
 typedef struct Interpolation Interpolation;
 typedef struct InterpolationFragment InterpolationFragment;
 typedef struct InterpolationFragmentList InterpolationFragmentList;
@@ -36,18 +34,32 @@ typedef struct Statement Statement;
 typedef struct Routine Routine;
 typedef struct Program Program;
 
-typedef struct ArithmeticExpression ArithmeticExpression;
-typedef struct UnaryExpression UnaryExpression;
-typedef struct BinaryExpression BinaryExpression;
-typedef struct RandomExpression RandomExpression;
-typedef struct ReplaceExpression ReplaceExpression;
+/**
+ * The index of an expression in the pool of its compilation. Expressions
+ * refer to their operands by index, so a reference takes 4 bytes instead of
+ * 8, and it remains valid while the pool grows.
+ */
+typedef uint32_t ExpressionId;
+
+#define NO_EXPRESSION			UINT32_MAX
+
+/**
+ * Every identifier is resolved by the semantic analysis into the slot of its
+ * symbol (the definition order), so the later phases never look a name up.
+ * Until then, it's unresolved.
+ */
+#define UNRESOLVED_SLOT			-1
 
 /**
 * Node types for the Abstract Syntax Tree (AST).
 */
 
 enum ExpressionType {
-	FACTOR_EXPRESSION,
+	ATOMIC_CONSTANT_EXPRESSION,
+	STRING_CONSTANT_EXPRESSION,
+	BUFFER_CONSTANT_EXPRESSION,
+	IDENTIFIER_EXPRESSION,
+	INTERPOLATION_EXPRESSION,
 	ARITHMETIC_EXPRESSION,
 	EXPRESSION_RND,
 	EXPRESSION_REV,
@@ -55,7 +67,9 @@ enum ExpressionType {
 	EXPRESSION_TLO,
 	EXPRESSION_LEN,
 	EXPRESSION_RPL,
-	EXPRESSION_ECP
+	EXPRESSION_MRP,
+	EXPRESSION_ECP,
+	REPLACEMENT_EXPRESSION
 };
 
 enum ArithmeticOperator {
@@ -71,13 +85,6 @@ enum ConstantType {
 	BUFFER_TYPE
 };
 
-enum FactorType {
-	CONSTANT_FACTOR,
-	EXPRESSION_FACTOR,
-	INTERPOLATION_FACTOR,
-	IDENTIFIER_FACTOR
-};
-
 enum StatementType {
 	STATEMENT_DECLARATION,
 	STATEMENT_EXPRESSION,
@@ -100,67 +107,45 @@ enum DeclarationType {
 
 // ----------------------------------------------------
 
-struct Constant {
-	ConstantType type;
-
-	union {
-		int atomic;
-		char* string;
-		struct Buffer* buffer;
-	};
-};
-
-struct ArithmeticExpression {
-	ArithmeticOperator operator;
-	Expression* left;
-	Expression* right;
-};
-
-struct UnaryExpression {
-	Expression* input;
-};
-
-struct BinaryExpression {
-    Expression* input;
-    Expression* key;
-};
-
-struct RandomExpression {
-	Expression* min;
-	Expression* max;
-	Expression* charset;
-};
-
-struct ReplaceExpression {
-	Expression* original;
-	Expression* target;
-	Expression* replacement;
-};
-
+/**
+ * A node of an expression, with its payload inlined. The operands are, in
+ * order: left and right (ARITHMETIC); input (REV, TUP, TLO and LEN); input
+ * and key (ECP); minimum, maximum and charset (RND); original, target and
+ * replacement (RPL); and original and first replacement (MRP). The
+ * replacements of MRP are not values, but a list of target, replacement and
+ * next replacement (or NO_EXPRESSION).
+ */
 struct Expression {
 	ExpressionType type;
+	ArithmeticOperator operator;
 
-	union {
-		Factor* factor;
-		ArithmeticExpression* arithmetic;
-		UnaryExpression* unary;
-		BinaryExpression* binary;
-		RandomExpression* random;
-		ReplaceExpression* replace;
-	};
-};
-
-struct Factor {
-	FactorType type;
+	// The type of its value (ATOMIC_TYPE or STRING_TYPE), inferred by the
+	// semantic analysis.
+	ConstantType valueType;
 
 	union {
-		Constant* constant;
-		Expression* expression;
+		int64_t atomic;
+		char* string;
+		Buffer* buffer;
+		struct {
+			char* identifier;
+			int slot;
+		};
 		Interpolation* interpolation;
-		char* identifier;
+		ExpressionId operands[3];
 	};
 };
 
+/**
+ * The expressions of a compilation, contiguous, in the order they were
+ * reduced (so every operand comes before its operator).
+ */
+struct ExpressionPool {
+	Expression* expressions;
+	uint32_t count;
+	uint32_t capacity;
+};
+
 struct InterpolationFragment {
 	InterpolationFragmentType type;
 
@@ -168,6 +153,7 @@ struct InterpolationFragment {
 		char* literal;
 		char* identifier;
 	};
+	int slot;
 	InterpolationFragment* next;
 };
 
@@ -177,60 +163,79 @@ struct InterpolationFragmentList {
 };
 
 struct Interpolation {
+	// In source order.
 	InterpolationFragmentList* fragments;
 };
 
 struct Declaration {
 	ConstantType type;
 	char* identifier;
+	int slot;
 
 	union {
-		int atomicValue;
 		char* stringValue;
 		Buffer* bufferValue;
-		Expression* expression;
+		ExpressionId expression;
 	};
 };
 
+/**
+ * The statements of a program or of a routine, contiguous and in source
+ * order.
+ */
 struct StatementList {
-	Statement* statement;
-	StatementList* next;
+	Statement** statements;
+	unsigned int count;
+	unsigned int capacity;
 };
 
 struct Statement {
 	StatementType type;
 
 	union {
-		char* routineCallName;
+		struct {
+			char* routineCallName;
+			int routineCallSlot;
+		};
 		Declaration* declaration;
 		struct Routine* routine;
-		Expression* expression;
+		ExpressionId expression;
 	};
 };
 
 struct Routine {
 	char* identifier;
+	int slot;
 	StatementList* body;
 };
 
 struct Program {
 	StatementList* statements;
+	const ExpressionPool* expressions;
 };
 
-// ----------------------------------------------------
+/**
+ * Creates an empty pool of expressions. Returns NULL if the system runs out
+ * of memory.
+ */
+ExpressionPool* createExpressionPool();
 
-void initializeAbstractSyntaxTreeModule();
-void shutdownAbstractSyntaxTreeModule();
+/**
+ * Destroy a pool, and every expression in it.
+ */
+void destroyExpressionPool(ExpressionPool* pool);
 
-Interpolation* createInterpolation();
+/**
+ * Appends a new expression of the specified type to the pool, and returns
+ * its index (or NO_EXPRESSION if the system runs out of memory). The pointer
+ * is valid only until the next expression is added.
+ */
+ExpressionId addExpression(ExpressionPool* pool, ExpressionType type, Expression** expression);
 
-void releaseProgram(Program* program);
-void releaseStatementList(StatementList* list);
-void releaseStatement(Statement* statement);
-void releaseRoutine(Routine* routine);
-void releaseExpression(Expression* expression);
-void releaseFactor(Factor* factor);
-void releaseInterpolation(Interpolation* interpolation);
-void releaseInterpolationFragmentList(InterpolationFragmentList* list);
+/**
+ * Releases the newest expressions of the pool, and keeps only the first
+ * "count" ones (but not their memory, which is reused).
+ */
+void truncateExpressionPool(ExpressionPool* pool, const uint32_t count);
 
 #endif
@@ -1,5 +1,7 @@
 #include "BisonActions.h"
 
+#define INITIAL_STATEMENT_CAPACITY		4
+
 /* MODULE INTERNAL STATE */
 
 static Logger * _logger = NULL;
@@ -14,14 +16,51 @@ void shutdownBisonActionsModule() {
 	}
 }
 
-/** IMPORTED FUNCTIONS */
-
-extern unsigned int flexCurrentContext(void);
-
 /* PRIVATE FUNCTIONS */
 
+static void * _allocate(CompilerState * compilerState, const size_t size);
+static ExpressionId _addExpression(CompilerState * compilerState, const ExpressionType type, Expression ** expression);
+static ExpressionId _addUnaryExpression(CompilerState * compilerState, const ExpressionType type, const ExpressionId input);
+static ExpressionId _addReplacement(CompilerState * compilerState, const ExpressionId target, const ExpressionId replacement, const ExpressionId next);
 static void _logSyntacticAnalyzerAction(const char * functionName);
 
+/**
+ * Allocates a node of the AST in the arena of the compilation.
+ */
+static void * _allocate(CompilerState * compilerState, const size_t size) {
+	return allocateInArena(compilerState->arena, size);
+}
+
+/**
+ * Appends a new expression to the pool of the compilation.
+ */
+static ExpressionId _addExpression(CompilerState * compilerState, const ExpressionType type, Expression ** expression) {
+	return addExpression(compilerState->expressions, type, expression);
+}
+
+static ExpressionId _addUnaryExpression(CompilerState * compilerState, const ExpressionType type, const ExpressionId input) {
+	Expression * expression = NULL;
+	const ExpressionId id = _addExpression(compilerState, type, &expression);
+	if (id != NO_EXPRESSION) {
+		expression->operands[0] = input;
+	}
+	return id;
+}
+
+/**
+ * A replacement of MRP, followed by the next one (or NO_EXPRESSION).
+ */
+static ExpressionId _addReplacement(CompilerState * compilerState, const ExpressionId target, const ExpressionId replacement, const ExpressionId next) {
+	Expression * expression = NULL;
+	const ExpressionId id = _addExpression(compilerState, REPLACEMENT_EXPRESSION, &expression);
+	if (id != NO_EXPRESSION) {
+		expression->operands[0] = target;
+		expression->operands[1] = replacement;
+		expression->operands[2] = next;
+	}
+	return id;
+}
+
 /**
  * Logs a syntactic-analyzer action in DEBUGGING level.
  */
@@ -34,10 +73,11 @@ static void _logSyntacticAnalyzerAction(const char * functionName) {
 Program* ProgramSemanticAction(CompilerState *compilerState, StatementList* statements) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Program* program = malloc(sizeof(Program));
+    Program* program = _allocate(compilerState, sizeof(Program));
     if (!program) { return NULL; }
 
     program->statements = statements;
+    program->expressions = compilerState->expressions;
 
     compilerState->abstractSyntaxtTree = program;
     compilerState->succeed = true;
@@ -45,24 +85,60 @@ Program* ProgramSemanticAction(CompilerState *compilerState, StatementList* stat
     return program;
 }
 
-StatementList* StatementListSemanticAction(StatementList* next, Statement* statement) {
+/**
+ * The grammar is left-recursive, so every statement is appended to the list
+ * of the previous ones. The array doubles its capacity when it's full (the
+ * old one stays in the arena, but the waste is bounded by the final size).
+ */
+StatementList* StatementListSemanticAction(CompilerState* compilerState, StatementList* list, Statement* statement) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    StatementList* list = malloc(sizeof(StatementList));
-    if (!list) { return NULL; }
+    if (!list) {
+        list = _allocate(compilerState, sizeof(StatementList));
+        if (!list) { return NULL; }
 
-    list->statement = statement;
-    list->next = next;
+        list->statements = NULL;
+        list->count = 0;
+        list->capacity = 0;
+    }
+
+    if (list->count == list->capacity) {
+        const unsigned int capacity = list->capacity == 0 ? INITIAL_STATEMENT_CAPACITY : 2 * list->capacity;
+        Statement** statements = _allocate(compilerState, capacity * sizeof(Statement*));
+        if (!statements) { return NULL; }
+
+        if (list->count) {
+            memcpy(statements, list->statements, list->count * sizeof(Statement*));
+        }
+        list->statements = statements;
+        list->capacity = capacity;
+    }
+
+    list->statements[list->count++] = statement;
 
     return list;
 }
 
+/**
+ * The top-level statements. In streaming mode, they are handed over to the
+ * caller of the parser one by one, so the list is never built.
+ */
+StatementList* ProgramStatementListSemanticAction(CompilerState* compilerState, StatementList* list, Statement* statement) {
+	_logSyntacticAnalyzerAction(__FUNCTION__);
+
+    if (compilerState->streaming) {
+        compilerState->streamedStatement = statement;
+        return NULL;
+    }
+    return StatementListSemanticAction(compilerState, list, statement);
+}
+
 // ---------------------------------------------------------------------------------------
 
-Statement* RoutineStatementSemanticAction(Routine* routine) {
+Statement* RoutineStatementSemanticAction(CompilerState* compilerState, Routine* routine) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Statement* statement = malloc(sizeof(Statement));
+    Statement* statement = _allocate(compilerState, sizeof(Statement));
     if (!statement) { return NULL; }
 
     statement->type = STATEMENT_ROUTINE;
@@ -72,22 +148,23 @@ Statement* RoutineStatementSemanticAction(Routine* routine) {
 }
 
 
-Statement* RoutineCallStatementSemanticAction(char* identifier) {
+Statement* RoutineCallStatementSemanticAction(CompilerState* compilerState, char* identifier) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Statement* statement = malloc(sizeof(Statement));
+    Statement* statement = _allocate(compilerState, sizeof(Statement));
     if (!statement) { return NULL; }
 
     statement->type = STATEMENT_ROUTINE_CALL;
     statement->routineCallName = identifier;
+    statement->routineCallSlot = UNRESOLVED_SLOT;
 
     return statement;
 }
 
-Statement* OutStatementSemanticAction(Expression* expression) {
+Statement* OutStatementSemanticAction(CompilerState* compilerState, ExpressionId expression) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Statement* statement = malloc(sizeof(Statement));
+    Statement* statement = _allocate(compilerState, sizeof(Statement));
     if (!statement) { return NULL; }
 
     statement->type = STATEMENT_OUTPUT;
@@ -96,10 +173,10 @@ Statement* OutStatementSemanticAction(Expression* expression) {
     return statement;
 }
 
-Statement* DeclarationStatementSemanticAction(Declaration* declaration) {
+Statement* DeclarationStatementSemanticAction(CompilerState* compilerState, Declaration* declaration) {
     _logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Statement* statement = malloc(sizeof(Statement));
+    Statement* statement = _allocate(compilerState, sizeof(Statement));
     if (!statement) { return NULL; }
 
     statement->type = STATEMENT_DECLARATION;
@@ -108,10 +185,10 @@ Statement* DeclarationStatementSemanticAction(Declaration* declaration) {
     return statement;
 }
 
-Statement* ExpressionStatementSemanticAction(Expression* expression) {
+Statement* ExpressionStatementSemanticAction(CompilerState* compilerState, ExpressionId expression) {
     _logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Statement* statement = malloc(sizeof(Statement));
+    Statement* statement = _allocate(compilerState, sizeof(Statement));
     if (!statement) { return NULL; }
 
     statement->type = STATEMENT_EXPRESSION;
@@ -120,13 +197,14 @@ Statement* ExpressionStatementSemanticAction(Expression* expression) {
     return statement;
 }
 
-Routine* RoutineSemanticAction(char* identifier, StatementList* body) {
+Routine* RoutineSemanticAction(CompilerState* compilerState, char* identifier, StatementList* body) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Routine* routine = malloc(sizeof(Routine));
+    Routine* routine = _allocate(compilerState, sizeof(Routine));
     if (!routine) { return NULL; }
 
     routine->identifier = identifier;
+    routine->slot = UNRESOLVED_SLOT;
     routine->body = body;
 
     return routine;
@@ -134,314 +212,235 @@ Routine* RoutineSemanticAction(char* identifier, StatementList* body) {
 
 // ---------------------------------------------------------------------------------------
 
-Expression* ArithmeticExpressionSemanticAction(Expression* left, Expression* right, ArithmeticOperator operator) {
+ExpressionId ArithmeticExpressionSemanticAction(CompilerState* compilerState, ExpressionId left, ExpressionId right, ArithmeticOperator operator) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Expression* expression = malloc(sizeof(Expression));
-    if (!expression) { return NULL; }
-
-    expression->type = ARITHMETIC_EXPRESSION;
-    expression->arithmetic = malloc(sizeof(*(expression->arithmetic)));
+    Expression* expression = NULL;
+    const ExpressionId id = _addExpression(compilerState, ARITHMETIC_EXPRESSION, &expression);
+    if (id == NO_EXPRESSION) { return NO_EXPRESSION; }
 
-    if (!expression->arithmetic) {
-        free(expression);
-        return NULL;
-    }
-    expression->arithmetic->operator = operator;
-    expression->arithmetic->left = left;
-    expression->arithmetic->right = right;
+    expression->operator = operator;
+    expression->operands[0] = left;
+    expression->operands[1] = right;
 
-    return expression;
+    return id;
 }
 
-Expression* FactorExpressionSemanticAction(Factor* factor) {
+ExpressionId RandomExpressionSemanticAction(CompilerState* compilerState, ExpressionId min, ExpressionId max, ExpressionId charset) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Expression* expression = malloc(sizeof(Expression));
-    if (!expression) { return NULL; }
+    Expression* expression = NULL;
+    const ExpressionId id = _addExpression(compilerState, EXPRESSION_RND, &expression);
+    if (id == NO_EXPRESSION) { return NO_EXPRESSION; }
 
-    expression->type = FACTOR_EXPRESSION;
-    expression->factor = factor;
+	expression->operands[0] = min;
+	expression->operands[1] = max;
+	expression->operands[2] = charset;
 
-    return expression;
+    return id;
 }
 
-Expression* RandomExpressionSemanticAction(Expression* min, Expression* max, Expression* charset) {
+ExpressionId ReverseExpressionSemanticAction(CompilerState* compilerState, ExpressionId input) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Expression* expression = malloc(sizeof(Expression));
-    if (!expression) { return NULL; }
-
-	expression->type = EXPRESSION_RND;
-    expression->random = malloc(sizeof(*(expression->random)));
-    
-    if (!expression->random) {
-        free(expression);
-        return NULL;
-    }
-
-	expression->random->min = min;
-	expression->random->max = max;
-	expression->random->charset = charset;
-
-    return expression;
+    return _addUnaryExpression(compilerState, EXPRESSION_REV, input);
 }
 
-Expression* ReverseExpressionSemanticAction(Expression* input) {
+ExpressionId ToUpperExpressionSemanticAction(CompilerState* compilerState, ExpressionId input) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Expression* expression = malloc(sizeof(Expression));
-    if (!expression) { return NULL; }
-
-    expression->type = EXPRESSION_REV;
-    expression->unary = malloc(sizeof(*(expression->unary)));
-
-    if (!expression->unary) {
-        free(expression);
-        return NULL;
-    }
-
-	expression->type = EXPRESSION_REV;
-	expression->unary->input = input;
-
-    return expression;
+    return _addUnaryExpression(compilerState, EXPRESSION_TUP, input);
 }
 
-Expression* ToUpperExpressionSemanticAction(Expression* input) {
+ExpressionId ToLowerExpressionSemanticAction(CompilerState* compilerState, ExpressionId input) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Expression* expression = malloc(sizeof(Expression));
-    if (!expression) { return NULL; }
-
-	expression->type = EXPRESSION_TUP;
-    expression->unary = malloc(sizeof(*(expression->unary)));
+    return _addUnaryExpression(compilerState, EXPRESSION_TLO, input);
+}
 
-    if (!expression->unary) {
-        free(expression);
-        return NULL;
-    }
-    expression->unary->input = input;
+ExpressionId LengthExpressionSemanticAction(CompilerState* compilerState, ExpressionId input) {
+    _logSyntacticAnalyzerAction(__FUNCTION__);
 
-    return expression;
+    return _addUnaryExpression(compilerState, EXPRESSION_LEN, input);
 }
 
-Expression* ToLowerExpressionSemanticAction(Expression* input) {
+ExpressionId ReplaceExpressionSemanticAction(CompilerState* compilerState, ExpressionId original, ExpressionId target, ExpressionId replacement) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Expression* expression = malloc(sizeof(Expression));
-    if (!expression) { return NULL; }
+    Expression* expression = NULL;
+    const ExpressionId id = _addExpression(compilerState, EXPRESSION_RPL, &expression);
+    if (id == NO_EXPRESSION) { return NO_EXPRESSION; }
 
-    expression->type = EXPRESSION_TLO;
-    expression->unary = malloc(sizeof(*(expression->unary)));
+	expression->operands[0] = original;
+	expression->operands[1] = target;
+	expression->operands[2] = replacement;
 
-    if (!expression->unary) {
-        free(expression);
-        return NULL;
-    }
-
-	expression->unary->input = input;
-
-    return expression;
+    return id;
 }
 
-Expression* LengthExpressionSemanticAction(Expression* input) {
-    _logSyntacticAnalyzerAction(__FUNCTION__);
- 
-    Expression* expression = malloc(sizeof(Expression));
-    if (!expression) { return NULL; }
+ExpressionId MultipleReplaceExpressionSemanticAction(CompilerState* compilerState, ExpressionId original, ExpressionId replacements) {
+	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    expression->type = EXPRESSION_LEN;
-    expression->unary = malloc(sizeof(*(expression->unary)));
+    Expression* expression = NULL;
+    const ExpressionId id = _addExpression(compilerState, EXPRESSION_MRP, &expression);
+    if (id == NO_EXPRESSION) { return NO_EXPRESSION; }
 
-    if (!expression->unary) {
-        free(expression);
-        return NULL;
-    }
+	expression->operands[0] = original;
+	expression->operands[1] = replacements;
 
-	expression->unary->input = input;
-
-    return expression;
+    return id;
 }
 
-Expression* ReplaceExpressionSemanticAction(Expression* original, Expression* target, Expression* replacement) {
+ExpressionId ReplacementSemanticAction(CompilerState* compilerState, ExpressionId target, ExpressionId replacement) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Expression* expression = malloc(sizeof(Expression));
-    if (!expression) { return NULL; }
+    return _addReplacement(compilerState, target, replacement, NO_EXPRESSION);
+}
 
-	expression->type = EXPRESSION_RPL;
-    expression->replace = malloc(sizeof(*(expression->replace)));
-    
-    if (!expression->replace) {
-        free(expression);
-        return NULL;
-    }
+ExpressionId ReplacementListSemanticAction(CompilerState* compilerState, ExpressionId target, ExpressionId replacement, ExpressionId replacements) {
+	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-	expression->replace->original = original;
-	expression->replace->target = target;
-	expression->replace->replacement = replacement;
+	// A missing tail ran out of memory, and it must not shorten the list.
+	if (replacements == NO_EXPRESSION) { return NO_EXPRESSION; }
 
-    return expression;
+    return _addReplacement(compilerState, target, replacement, replacements);
 }
 
-Expression* EncryptionExpressionSemanticAction(Expression* input, Expression* key) {
+ExpressionId EncryptionExpressionSemanticAction(CompilerState* compilerState, ExpressionId input, ExpressionId key) {
     _logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Expression* expression = malloc(sizeof(Expression));
-    if (!expression) { return NULL; }
+    Expression* expression = NULL;
+    const ExpressionId id = _addExpression(compilerState, EXPRESSION_ECP, &expression);
+    if (id == NO_EXPRESSION) { return NO_EXPRESSION; }
 
-    BinaryExpression* binary = malloc(sizeof(BinaryExpression));
-    if (!binary) {
-        free(expression);
-        return NULL;
-    }
-
-    binary->input = input;
-    binary->key = key;
+    expression->operands[0] = input;
+    expression->operands[1] = key;
 
-    expression->type = EXPRESSION_ECP;
-    expression->binary = binary;
-
-    return expression;
+    return id;
 }
 
 // ---------------------------------------------------------------------------------------
 
-Factor* ConstantFactorSemanticAction(Constant* constant) {
-	_logSyntacticAnalyzerAction(__FUNCTION__);
-
-    Factor* factor = malloc(sizeof(Factor));
-    if (!factor) { return NULL; }
-
-    factor->type = CONSTANT_FACTOR;
-    factor->constant = constant;
-
-    return factor;
-}
-
-Factor* ExpressionFactorSemanticAction(Expression* expression) {
-	_logSyntacticAnalyzerAction(__FUNCTION__);
-
-    Factor* factor = malloc(sizeof(Factor));
-    if (!factor) { return NULL; }
-
-    factor->type = EXPRESSION_FACTOR;
-    factor->expression = expression;
-
-    return factor;
-}
-
-Factor* InterpolationFactorSemanticAction(Interpolation* interpolation) {
+ExpressionId InterpolationExpressionSemanticAction(CompilerState* compilerState, Interpolation* interpolation) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Factor* factor = malloc(sizeof(Factor));
-    if (!factor) { return NULL; }
+    Expression* expression = NULL;
+    const ExpressionId id = _addExpression(compilerState, INTERPOLATION_EXPRESSION, &expression);
+    if (id == NO_EXPRESSION) { return NO_EXPRESSION; }
 
-    factor->type = INTERPOLATION_FACTOR;
-    factor->interpolation = interpolation;
+    expression->interpolation = interpolation;
 
-    return factor;
+    return id;
 }
 
-Factor* IdentifierFactorSemanticAction(char* identifier) {
+ExpressionId IdentifierExpressionSemanticAction(CompilerState* compilerState, char* identifier) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-	Factor* factor = malloc(sizeof(Factor));
-	if (!factor) { return NULL; }
+	Expression* expression = NULL;
+	const ExpressionId id = _addExpression(compilerState, IDENTIFIER_EXPRESSION, &expression);
+	if (id == NO_EXPRESSION) { return NO_EXPRESSION; }
 
-	factor->type = IDENTIFIER_FACTOR;
-	factor->identifier = identifier;
+	expression->identifier = identifier;
+	expression->slot = UNRESOLVED_SLOT;
 
-	return factor;
+	return id;
 }
 
 // ---------------------------------------------------------------------------------------
 
-Constant* AtomicConstantSemanticAction(int value) {
+ExpressionId AtomicConstantSemanticAction(CompilerState* compilerState, int64_t value) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Constant* constant = malloc(sizeof(Constant));
-    if (!constant) { return NULL; }
+    Expression* expression = NULL;
+    const ExpressionId id = _addExpression(compilerState, ATOMIC_CONSTANT_EXPRESSION, &expression);
+    if (id == NO_EXPRESSION) { return NO_EXPRESSION; }
 
-    constant->type = ATOMIC_TYPE;
-    constant->atomic = value;
+    expression->atomic = value;
 
-    return constant;
+    return id;
 }
 
-Constant* StringConstantSemanticAction(char* value) {
+ExpressionId StringConstantSemanticAction(CompilerState* compilerState, char* value) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Constant* constant = malloc(sizeof(Constant));
-    if (!constant) { return NULL; }
+    Expression* expression = NULL;
+    const ExpressionId id = _addExpression(compilerState, STRING_CONSTANT_EXPRESSION, &expression);
+    if (id == NO_EXPRESSION) { return NO_EXPRESSION; }
 
-    constant->type = STRING_TYPE;
-    constant->string = value;
+    expression->string = value;
 
-    return constant;
+    return id;
 }
 
-Constant* BufferConstantSemanticAction(Buffer* buffer) {
+ExpressionId BufferConstantSemanticAction(CompilerState* compilerState, Buffer* buffer) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Constant* constant = malloc(sizeof(Constant));
-    if (!constant) { return NULL; }
+    Expression* expression = NULL;
+    const ExpressionId id = _addExpression(compilerState, BUFFER_CONSTANT_EXPRESSION, &expression);
+    if (id == NO_EXPRESSION) { return NO_EXPRESSION; }
 
-    constant->type = BUFFER_TYPE;
-    constant->buffer = buffer;
+    expression->buffer = buffer;
 
-    return constant;
+    return id;
 }
 
 // ---------------------------------------------------------------------------------------
 
-Declaration* StringDeclarationSemanticAction(char* identifier, char* literal) {
+Declaration* StringDeclarationSemanticAction(CompilerState* compilerState, char* identifier, char* literal) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Declaration* declaration = malloc(sizeof(Declaration));
+    Declaration* declaration = _allocate(compilerState, sizeof(Declaration));
     if (!declaration) { return NULL; }
 
     declaration->type = STRING_TYPE;
     declaration->identifier = identifier;
+    declaration->slot = UNRESOLVED_SLOT;
     declaration->stringValue = literal;
 
     return declaration;
 }
 
-Declaration* AtomicDeclarationSemanticAction(char* identifier, int value) {
+/**
+ * The value is kept as a constant expression, so every declaration is
+ * evaluated in the same way.
+ */
+Declaration* AtomicDeclarationSemanticAction(CompilerState* compilerState, char* identifier, int64_t value) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Declaration* declaration = malloc(sizeof(Declaration));
+    Declaration* declaration = _allocate(compilerState, sizeof(Declaration));
     if (!declaration) { return NULL; }
 
     declaration->type = ATOMIC_TYPE;
     declaration->identifier = identifier;
-    declaration->atomicValue = value;
+    declaration->slot = UNRESOLVED_SLOT;
+    declaration->expression = AtomicConstantSemanticAction(compilerState, value);
 
     return declaration;
 }
 
-Declaration* BufferDeclarationSemanticAction(char* identifier, Buffer* buffer) {
+Declaration* BufferDeclarationSemanticAction(CompilerState* compilerState, char* identifier, Buffer* buffer) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Declaration* declaration = malloc(sizeof(Declaration));
+    Declaration* declaration = _allocate(compilerState, sizeof(Declaration));
     if (!declaration) { return NULL; }
 
     declaration->type = BUFFER_TYPE;
     declaration->identifier = identifier;
+    declaration->slot = UNRESOLVED_SLOT;
     declaration->bufferValue = buffer;
 
     return declaration;
 }
 
-Declaration* StringExpressionDeclarationSemanticAction(char* identifier, Expression* expression) { 
+Declaration* StringExpressionDeclarationSemanticAction(CompilerState* compilerState, char* identifier, ExpressionId expression) { 
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Declaration* declaration = malloc(sizeof(Declaration));
+    Declaration* declaration = _allocate(compilerState, sizeof(Declaration));
     if (!declaration) { return NULL; }
 
     declaration->type = STRING_TYPE;
     declaration->identifier = identifier;
+    declaration->slot = UNRESOLVED_SLOT;
     declaration->expression = expression;
 
     return declaration;
@@ -449,21 +448,33 @@ Declaration* StringExpressionDeclarationSemanticAction(char* identifier, Express
 
 // ---------------------------------------------------------------------------------------
 
-Interpolation* InterpolationSemanticAction(InterpolationFragmentList* list) {
+/**
+ * The fragment list is built backwards (every fragment is prepended), so it
+ * gets reversed in place once, and the interpolation keeps its fragments in
+ * source order.
+ */
+Interpolation* InterpolationSemanticAction(CompilerState* compilerState, InterpolationFragmentList* list) {
     _logSyntacticAnalyzerAction(__FUNCTION__);
 
-    Interpolation* interpolation = malloc(sizeof(Interpolation));
+    Interpolation* interpolation = _allocate(compilerState, sizeof(Interpolation));
     if (!interpolation) { return NULL; }
-    
-    interpolation->fragments = list;
+
+    InterpolationFragmentList* reversed = NULL;
+    while (list) {
+        InterpolationFragmentList* next = list->next;
+        list->next = reversed;
+        reversed = list;
+        list = next;
+    }
+    interpolation->fragments = reversed;
 
     return interpolation;
 }
 
-InterpolationFragmentList* InterpolationFragmentListSemanticAction(InterpolationFragmentList* next, InterpolationFragment* fragment) {
+InterpolationFragmentList* InterpolationFragmentListSemanticAction(CompilerState* compilerState, InterpolationFragmentList* next, InterpolationFragment* fragment) {
     _logSyntacticAnalyzerAction(__FUNCTION__);
 
-    InterpolationFragmentList* list = malloc(sizeof(InterpolationFragmentList));
+    InterpolationFragmentList* list = _allocate(compilerState, sizeof(InterpolationFragmentList));
     if (!list) { return NULL; }
 
     list->head = fragment;
@@ -474,27 +485,29 @@ InterpolationFragmentList* InterpolationFragmentListSemanticAction(Interpolation
 
 // ---------------------------------------------------------------------------------------
 
-InterpolationFragment* LiteralFragmentSemanticAction(char* literal) {
+InterpolationFragment* LiteralFragmentSemanticAction(CompilerState* compilerState, char* literal) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-	InterpolationFragment* fragment = malloc(sizeof(InterpolationFragment));
+	InterpolationFragment* fragment = _allocate(compilerState, sizeof(InterpolationFragment));
 	if (!fragment) { return NULL; }
 
 	fragment->type = LITERAL_FRAGMENT;
 	fragment->literal = literal;
+	fragment->slot = UNRESOLVED_SLOT;
 	fragment->next = NULL;
 
 	return fragment;
 }
 
-InterpolationFragment* ExpressionFragmentSemanticAction(char* identifier) {
+InterpolationFragment* ExpressionFragmentSemanticAction(CompilerState* compilerState, char* identifier) {
 	_logSyntacticAnalyzerAction(__FUNCTION__);
 
-	InterpolationFragment* fragment = malloc(sizeof(InterpolationFragment));
+	InterpolationFragment* fragment = _allocate(compilerState, sizeof(InterpolationFragment));
 	if (!fragment) { return NULL; }
 
 	fragment->type = EXPRESSION_FRAGMENT;
 	fragment->identifier = identifier;
+	fragment->slot = UNRESOLVED_SLOT;
 	fragment->next = NULL;
 
 	return fragment;
@@ -7,6 +7,7 @@
 #include "AbstractSyntaxTree.h"
 #include "SyntacticAnalyzer.h"
 #include <stdlib.h>
+#include <string.h>
 
 /** Initialize module's internal state. */
 void initializeBisonActionsModule();
@@ -19,43 +20,44 @@ void shutdownBisonActionsModule();
  */
 
 Program* ProgramSemanticAction(CompilerState *compilerState, StatementList* statements);
-StatementList* StatementListSemanticAction(StatementList* next, Statement* statement);
-
-Statement* RoutineStatementSemanticAction(Routine* routine);
-Statement* RoutineCallStatementSemanticAction(char* identifier);
-Statement* OutStatementSemanticAction(Expression* expression);
-Statement* DeclarationStatementSemanticAction(Declaration* declaration);
-Statement* ExpressionStatementSemanticAction(Expression* expression);
-
-Routine* RoutineSemanticAction(char* id, StatementList* body);
-Declaration* StringDeclarationSemanticAction(char* id, char* value);
-Declaration* AtomicDeclarationSemanticAction(char* id, int value);
-Declaration* BufferDeclarationSemanticAction(char* id, Buffer* buffer);
-Declaration* StringExpressionDeclarationSemanticAction(char* id, Expression* expr);
-
-Expression* FactorExpressionSemanticAction(Factor* factor);
-Expression* ArithmeticExpressionSemanticAction(Expression* left, Expression* right, ArithmeticOperator operator);
-Expression* RandomExpressionSemanticAction(Expression* min, Expression* max, Expression* charset);
-Expression* ReverseExpressionSemanticAction(Expression* input);
-Expression* ToUpperExpressionSemanticAction(Expression* input);
-Expression* ToLowerExpressionSemanticAction(Expression* input);
-Expression* LengthExpressionSemanticAction(Expression* input);
-Expression* ReplaceExpressionSemanticAction(Expression* original, Expression* target, Expression* replacement);
-Expression* EncryptionExpressionSemanticAction(Expression* input, Expression* key);
-
-Factor* ConstantFactorSemanticAction(Constant* constant);
-Factor* ExpressionFactorSemanticAction(Expression* expression);
-Factor* InterpolationFactorSemanticAction(Interpolation* interpolation);
-Factor* IdentifierFactorSemanticAction(char* identifier);
-
-Constant* AtomicConstantSemanticAction(int value);
-Constant* StringConstantSemanticAction(char* value);
-Constant* BufferConstantSemanticAction(Buffer* value);
-
-Interpolation* InterpolationSemanticAction(InterpolationFragmentList* list);
-InterpolationFragmentList* InterpolationFragmentListSemanticAction(InterpolationFragmentList* next, InterpolationFragment* fragment);
-
-InterpolationFragment* LiteralFragmentSemanticAction(char* text);
-InterpolationFragment* ExpressionFragmentSemanticAction(char* identifier);
+StatementList* ProgramStatementListSemanticAction(CompilerState* compilerState, StatementList* list, Statement* statement);
+StatementList* StatementListSemanticAction(CompilerState* compilerState, StatementList* list, Statement* statement);
+
+Statement* RoutineStatementSemanticAction(CompilerState* compilerState, Routine* routine);
+Statement* RoutineCallStatementSemanticAction(CompilerState* compilerState, char* identifier);
+Statement* OutStatementSemanticAction(CompilerState* compilerState, ExpressionId expression);
+Statement* DeclarationStatementSemanticAction(CompilerState* compilerState, Declaration* declaration);
+Statement* ExpressionStatementSemanticAction(CompilerState* compilerState, ExpressionId expression);
+
+Routine* RoutineSemanticAction(CompilerState* compilerState, char* id, StatementList* body);
+Declaration* StringDeclarationSemanticAction(CompilerState* compilerState, char* id, char* value);
+Declaration* AtomicDeclarationSemanticAction(CompilerState* compilerState, char* id, int64_t value);
+Declaration* BufferDeclarationSemanticAction(CompilerState* compilerState, char* id, Buffer* buffer);
+Declaration* StringExpressionDeclarationSemanticAction(CompilerState* compilerState, char* id, ExpressionId expr);
+
+ExpressionId ArithmeticExpressionSemanticAction(CompilerState* compilerState, ExpressionId left, ExpressionId right, ArithmeticOperator operator);
+ExpressionId RandomExpressionSemanticAction(CompilerState* compilerState, ExpressionId min, ExpressionId max, ExpressionId charset);
+ExpressionId ReverseExpressionSemanticAction(CompilerState* compilerState, ExpressionId input);
+ExpressionId ToUpperExpressionSemanticAction(CompilerState* compilerState, ExpressionId input);
+ExpressionId ToLowerExpressionSemanticAction(CompilerState* compilerState, ExpressionId input);
+ExpressionId LengthExpressionSemanticAction(CompilerState* compilerState, ExpressionId input);
+ExpressionId ReplaceExpressionSemanticAction(CompilerState* compilerState, ExpressionId original, ExpressionId target, ExpressionId replacement);
+ExpressionId MultipleReplaceExpressionSemanticAction(CompilerState* compilerState, ExpressionId original, ExpressionId replacements);
+ExpressionId ReplacementSemanticAction(CompilerState* compilerState, ExpressionId target, ExpressionId replacement);
+ExpressionId ReplacementListSemanticAction(CompilerState* compilerState, ExpressionId target, ExpressionId replacement, ExpressionId replacements);
+ExpressionId EncryptionExpressionSemanticAction(CompilerState* compilerState, ExpressionId input, ExpressionId key);
+
+ExpressionId InterpolationExpressionSemanticAction(CompilerState* compilerState, Interpolation* interpolation);
+ExpressionId IdentifierExpressionSemanticAction(CompilerState* compilerState, char* identifier);
+
+ExpressionId AtomicConstantSemanticAction(CompilerState* compilerState, int64_t value);
+ExpressionId StringConstantSemanticAction(CompilerState* compilerState, char* value);
+ExpressionId BufferConstantSemanticAction(CompilerState* compilerState, Buffer* value);
+
+Interpolation* InterpolationSemanticAction(CompilerState* compilerState, InterpolationFragmentList* list);
+InterpolationFragmentList* InterpolationFragmentListSemanticAction(CompilerState* compilerState, InterpolationFragmentList* next, InterpolationFragment* fragment);
+
+InterpolationFragment* LiteralFragmentSemanticAction(CompilerState* compilerState, char* text);
+InterpolationFragment* ExpressionFragmentSemanticAction(CompilerState* compilerState, char* identifier);
 
 #endif
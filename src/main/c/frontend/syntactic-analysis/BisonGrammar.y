@@ -7,20 +7,38 @@
 // You touch this, and you die.
 %define api.value.union.name SemanticValue
 
+/**
+ * A pure (reentrant) parser: the scanner and the compiler state of the
+ * compilation are parameters, so there are no globals involved.
+ *
+ * @see https://www.gnu.org/software/bison/manual/html_node/Pure-Decl.html
+ * @see https://www.gnu.org/software/bison/manual/html_node/Pure-Calling.html
+ */
+%define api.pure full
+
+/**
+ * Both a pull parser ("yyparse"), and a push parser ("yypush_parse") that
+ * receives one token at a time, so the caller can run every statement as
+ * soon as it's reduced.
+ *
+ * @see https://www.gnu.org/software/bison/manual/html_node/Push-Decl.html
+ */
+%define api.push-pull both
+%lex-param {yyscan_t scanner}
+%parse-param {yyscan_t scanner} {CompilerState * compilerState}
+
 %union {
 
 	/** Terminals. */
 	int integer;
-	int atomic;
+	int64_t atomic;
 	char* string;
 	Buffer* buffer;
 	Token token;
 
 	/** Non-terminals. */
 
-	Constant* constant;
-	Expression* expression;
-	Factor* factor;
+	ExpressionId expression;
 	Program* program;
 
 	Routine* routine;
@@ -33,31 +51,17 @@
 }
 
 /**
- * Destructors. This functions are executed after the parsing ends, so if the
- * AST must be used in the following phases of the compiler you shouldn't used
- * this approach. To use this mechanism, the AST must be translated into
- * another structure.
+ * Destructors are not needed: every node of the AST (and every lexeme) is
+ * allocated in the arena of the compilation, so even the nodes discarded
+ * during an error recovery are released at once, together with the AST.
  *
  * @see https://www.gnu.org/software/bison/manual/html_node/Destructor-Decl.html
  */
-/*	Need syntax tree for nexts steps
-%destructor { releaseConstant($$); } <constant>
-%destructor { releaseExpression($$); } <expression>
-%destructor { releaseFactor($$); } <factor>
-%destructor { releaseProgram($$); } <program>
-%destructor { releaseRoutine($$); } <routine>
-%destructor { releaseDeclaration($$); } <declaration>
-%destructor { releaseStatement($$); } <statement>
-%destructor { releaseStatementList($$); } <statementList>
-%destructor { releaseInterpolation($$); } <interpolation>
-%destructor { releaseInterpolationFragment($$); } <interpolation_fragment>
-%destructor { releaseInterpolationFragmentList($$); } <interpolation_fragment_list>
-*/
 
 /** Terminals. */
 
 %token <token> STRING_TYPE_TOKEN ATOMIC_TYPE_TOKEN BUFFER_TYPE_TOKEN
-%token <token> RND_TOKEN REV_TOKEN TUP_TOKEN TLO_TOKEN RPL_TOKEN LEN_TOKEN ECP_TOKEN
+%token <token> RND_TOKEN REV_TOKEN TUP_TOKEN TLO_TOKEN RPL_TOKEN MRP_TOKEN LEN_TOKEN ECP_TOKEN
 %token <token> FUN_TOKEN OUT_TOKEN
 %token <token> STRING_START_TOKEN STRING_END_TOKEN
 
@@ -76,14 +80,16 @@
 
 /** Non-terminals. */
 
-%type <constant> constant
+%type <expression> constant
 %type <expression> expression
-%type <factor> factor
+%type <expression> factor
+%type <expression> replacement_list
 %type <program> program
 
 %type <routine> routine
 %type <statement> statement
 %type <declaration> declaration
+%type <statementList> program_statement_list
 %type <statementList> statement_list
 %type <interpolation> interpolation
 %type <interpolation_fragment> interpolation_fragment
@@ -103,72 +109,83 @@
 // IMPORTANT: To use λ in the following grammar, use the %empty symbol.
 
 program:
-	statement_list													{ $$ = ProgramSemanticAction(currentCompilerState(), $1); }
-	| %empty														{ $$ = ProgramSemanticAction(currentCompilerState(), NULL);; }
+	program_statement_list											{ $$ = ProgramSemanticAction(compilerState, $1); }
+	| %empty														{ $$ = ProgramSemanticAction(compilerState, NULL);; }
+	;
+
+program_statement_list:
+	statement SEMICOLON_TOKEN										{ $$ = ProgramStatementListSemanticAction(compilerState, NULL, $1); }
+	| program_statement_list statement SEMICOLON_TOKEN				{ $$ = ProgramStatementListSemanticAction(compilerState, $1, $2); }
 	;
 
 statement_list:
-	statement SEMICOLON_TOKEN										{ $$ = StatementListSemanticAction(NULL, $1); }
-	| statement_list statement SEMICOLON_TOKEN						{ $$ = StatementListSemanticAction($1, $2); }
+	statement SEMICOLON_TOKEN										{ $$ = StatementListSemanticAction(compilerState, NULL, $1); }
+	| statement_list statement SEMICOLON_TOKEN						{ $$ = StatementListSemanticAction(compilerState, $1, $2); }
 
 statement:
-	declaration														{ $$ = DeclarationStatementSemanticAction($1); }
-	| expression													{ $$ = ExpressionStatementSemanticAction($1); }
-	| routine														{ $$ = RoutineStatementSemanticAction($1); }
-	| OUT_TOKEN expression											{ $$ = OutStatementSemanticAction($2); }
-	| ROUTINE_CALL_TOKEN											{ $$ = RoutineCallStatementSemanticAction($1); }
+	declaration														{ $$ = DeclarationStatementSemanticAction(compilerState, $1); }
+	| expression													{ $$ = ExpressionStatementSemanticAction(compilerState, $1); }
+	| routine														{ $$ = RoutineStatementSemanticAction(compilerState, $1); }
+	| OUT_TOKEN expression											{ $$ = OutStatementSemanticAction(compilerState, $2); }
+	| ROUTINE_CALL_TOKEN											{ $$ = RoutineCallStatementSemanticAction(compilerState, $1); }
 
 expression:
-	  expression ADD_TOKEN expression								{ $$ = ArithmeticExpressionSemanticAction($1, $3, ADDITION); }
-	| expression SUB_TOKEN expression								{ $$ = ArithmeticExpressionSemanticAction($1, $3, SUBTRACTION); }
-	| expression MUL_TOKEN expression								{ $$ = ArithmeticExpressionSemanticAction($1, $3, MULTIPLICATION); }
-	| expression DIV_TOKEN expression								{ $$ = ArithmeticExpressionSemanticAction($1, $3, DIVISION); }
-	| RND_TOKEN OPEN_PAREN_TOKEN expression COMMA_TOKEN expression COMMA_TOKEN expression CLOSE_PAREN_TOKEN { $$ = RandomExpressionSemanticAction($3, $5, $7); }
-	| REV_TOKEN OPEN_PAREN_TOKEN expression CLOSE_PAREN_TOKEN		{ $$ = ReverseExpressionSemanticAction($3); }
-	| TUP_TOKEN OPEN_PAREN_TOKEN expression CLOSE_PAREN_TOKEN		{ $$ = ToUpperExpressionSemanticAction($3); }
-	| TLO_TOKEN OPEN_PAREN_TOKEN expression CLOSE_PAREN_TOKEN		{ $$ = ToLowerExpressionSemanticAction($3); }
-	| LEN_TOKEN OPEN_PAREN_TOKEN expression CLOSE_PAREN_TOKEN		{ $$ = LengthExpressionSemanticAction($3); }
-	| RPL_TOKEN OPEN_PAREN_TOKEN expression COMMA_TOKEN expression COMMA_TOKEN expression CLOSE_PAREN_TOKEN { $$ = ReplaceExpressionSemanticAction($3, $5, $7); }
-	| ECP_TOKEN OPEN_PAREN_TOKEN expression COMMA_TOKEN expression CLOSE_PAREN_TOKEN						{ $$ = EncryptionExpressionSemanticAction($3, $5); }
-	| factor														{ $$ = FactorExpressionSemanticAction($1); }
+	  expression ADD_TOKEN expression								{ $$ = ArithmeticExpressionSemanticAction(compilerState, $1, $3, ADDITION); }
+	| expression SUB_TOKEN expression								{ $$ = ArithmeticExpressionSemanticAction(compilerState, $1, $3, SUBTRACTION); }
+	| expression MUL_TOKEN expression								{ $$ = ArithmeticExpressionSemanticAction(compilerState, $1, $3, MULTIPLICATION); }
+	| expression DIV_TOKEN expression								{ $$ = ArithmeticExpressionSemanticAction(compilerState, $1, $3, DIVISION); }
+	| RND_TOKEN OPEN_PAREN_TOKEN expression COMMA_TOKEN expression COMMA_TOKEN expression CLOSE_PAREN_TOKEN { $$ = RandomExpressionSemanticAction(compilerState, $3, $5, $7); }
+	| REV_TOKEN OPEN_PAREN_TOKEN expression CLOSE_PAREN_TOKEN		{ $$ = ReverseExpressionSemanticAction(compilerState, $3); }
+	| TUP_TOKEN OPEN_PAREN_TOKEN expression CLOSE_PAREN_TOKEN		{ $$ = ToUpperExpressionSemanticAction(compilerState, $3); }
+	| TLO_TOKEN OPEN_PAREN_TOKEN expression CLOSE_PAREN_TOKEN		{ $$ = ToLowerExpressionSemanticAction(compilerState, $3); }
+	| LEN_TOKEN OPEN_PAREN_TOKEN expression CLOSE_PAREN_TOKEN		{ $$ = LengthExpressionSemanticAction(compilerState, $3); }
+	| RPL_TOKEN OPEN_PAREN_TOKEN expression COMMA_TOKEN expression COMMA_TOKEN expression CLOSE_PAREN_TOKEN { $$ = ReplaceExpressionSemanticAction(compilerState, $3, $5, $7); }
+	| MRP_TOKEN OPEN_PAREN_TOKEN expression COMMA_TOKEN replacement_list CLOSE_PAREN_TOKEN		{ $$ = MultipleReplaceExpressionSemanticAction(compilerState, $3, $5); }
+	| ECP_TOKEN OPEN_PAREN_TOKEN expression COMMA_TOKEN expression CLOSE_PAREN_TOKEN						{ $$ = EncryptionExpressionSemanticAction(compilerState, $3, $5); }
+	| factor														{ $$ = $1; }
 	;
 
 factor:
-	  OPEN_PAREN_TOKEN expression CLOSE_PAREN_TOKEN					{ $$ = ExpressionFactorSemanticAction($2); }
-	| IDENTIFIER_TOKEN												{ $$ = IdentifierFactorSemanticAction($1); }
-	| constant														{ $$ = ConstantFactorSemanticAction($1); }
-	| interpolation													{ $$ = InterpolationFactorSemanticAction($1); }
+	  OPEN_PAREN_TOKEN expression CLOSE_PAREN_TOKEN					{ $$ = $2; }
+	| IDENTIFIER_TOKEN												{ $$ = IdentifierExpressionSemanticAction(compilerState, $1); }
+	| constant														{ $$ = $1; }
+	| interpolation													{ $$ = InterpolationExpressionSemanticAction(compilerState, $1); }
+	;
+
+replacement_list:
+	  expression COMMA_TOKEN expression								{ $$ = ReplacementSemanticAction(compilerState, $1, $3); }
+	| expression COMMA_TOKEN expression COMMA_TOKEN replacement_list	{ $$ = ReplacementListSemanticAction(compilerState, $1, $3, $5); }
 	;
 
 constant:
-	  ATOMIC_TOKEN													{ $$ = AtomicConstantSemanticAction($1); }
-	| STRING_TOKEN													{ $$ = StringConstantSemanticAction($1); }
-	| BUFFER_TOKEN 													{ $$ = BufferConstantSemanticAction($1); }
+	  ATOMIC_TOKEN													{ $$ = AtomicConstantSemanticAction(compilerState, $1); }
+	| STRING_TOKEN													{ $$ = StringConstantSemanticAction(compilerState, $1); }
+	| BUFFER_TOKEN 													{ $$ = BufferConstantSemanticAction(compilerState, $1); }
 	;
 
 routine:
-	FUN_TOKEN IDENTIFIER_TOKEN OPEN_BRACE_TOKEN statement_list CLOSE_BRACE_TOKEN		{ $$ = RoutineSemanticAction($2, $4); }
+	FUN_TOKEN IDENTIFIER_TOKEN OPEN_BRACE_TOKEN statement_list CLOSE_BRACE_TOKEN		{ $$ = RoutineSemanticAction(compilerState, $2, $4); }
 	;
 
 declaration:
-	ATOMIC_TYPE_TOKEN IDENTIFIER_TOKEN ASSIGN_TOKEN ATOMIC_TOKEN 		{ $$ = AtomicDeclarationSemanticAction($2, $4); }
-	| BUFFER_TYPE_TOKEN IDENTIFIER_TOKEN ASSIGN_TOKEN BUFFER_TOKEN		{ $$ = BufferDeclarationSemanticAction($2, $4); }
-	| STRING_TYPE_TOKEN IDENTIFIER_TOKEN ASSIGN_TOKEN expression		{ $$ = StringExpressionDeclarationSemanticAction($2, $4); }
+	ATOMIC_TYPE_TOKEN IDENTIFIER_TOKEN ASSIGN_TOKEN ATOMIC_TOKEN 		{ $$ = AtomicDeclarationSemanticAction(compilerState, $2, $4); }
+	| BUFFER_TYPE_TOKEN IDENTIFIER_TOKEN ASSIGN_TOKEN BUFFER_TOKEN		{ $$ = BufferDeclarationSemanticAction(compilerState, $2, $4); }
+	| STRING_TYPE_TOKEN IDENTIFIER_TOKEN ASSIGN_TOKEN expression		{ $$ = StringExpressionDeclarationSemanticAction(compilerState, $2, $4); }
 	;
 
 interpolation:
-	STRING_START_TOKEN interpolation_fragment_list STRING_END_TOKEN		{ $$ = InterpolationSemanticAction($2); }
+	STRING_START_TOKEN interpolation_fragment_list STRING_END_TOKEN		{ $$ = InterpolationSemanticAction(compilerState, $2); }
 	;
 
 interpolation_fragment_list:
-	  interpolation_fragment											{ $$ = InterpolationFragmentListSemanticAction(NULL, $1); }
-	| interpolation_fragment_list interpolation_fragment				{ $$ = InterpolationFragmentListSemanticAction($1, $2); }
+	  interpolation_fragment											{ $$ = InterpolationFragmentListSemanticAction(compilerState, NULL, $1); }
+	| interpolation_fragment_list interpolation_fragment				{ $$ = InterpolationFragmentListSemanticAction(compilerState, $1, $2); }
 	;
 
 interpolation_fragment:
-	  STRING_TOKEN																		{ $$ = LiteralFragmentSemanticAction($1); }
-	| INTERPOLATED_IDENTIFIER_TOKEN														{ $$ = ExpressionFragmentSemanticAction($1); }
-	| INTERPOLATION_OPEN_TOKEN IDENTIFIER_TOKEN INTERPOLATION_CLOSE_TOKEN				{ $$ = ExpressionFragmentSemanticAction($2); }
+	  STRING_TOKEN																		{ $$ = LiteralFragmentSemanticAction(compilerState, $1); }
+	| INTERPOLATED_IDENTIFIER_TOKEN														{ $$ = ExpressionFragmentSemanticAction(compilerState, $1); }
+	| INTERPOLATION_OPEN_TOKEN IDENTIFIER_TOKEN INTERPOLATION_CLOSE_TOKEN				{ $$ = ExpressionFragmentSemanticAction(compilerState, $2); }
 	;
 
 %%
\ No newline at end of file
@@ -1,9 +1,9 @@
 #include "SyntacticAnalyzer.h"
 #include "../lexical-analysis/LexicalAnalyzerContext.h"
+#include "BisonParser.h"
 
 /* MODULE INTERNAL STATE */
 
-static CompilerState * _currentCompilerState = NULL;
 static Logger * _logger = NULL;
 
 void initializeSyntacticAnalyzerModule() {
@@ -18,40 +18,63 @@ void shutdownSyntacticAnalyzerModule() {
 
 /** IMPORTED FUNCTIONS */
 
-extern LexicalAnalyzerContext * createLexicalAnalyzerContext();
-
 /**
- * Bison exported functions.
+ * Flex exported functions.
  *
- * @see https://www.gnu.org/software/bison/manual/html_node/Error-Reporting-Function.html
+ * @see https://westes.github.io/flex/manual/Init-and-Destroy-Functions.html
+ * @see https://westes.github.io/flex/manual/Multiple-Input-Buffers.html
  */
+extern int yylex_init_extra(CompilerState * compilerState, yyscan_t * scanner);
+extern int yylex_destroy(yyscan_t scanner);
+extern struct yy_buffer_state * yy_scan_buffer(char * base, size_t size, yyscan_t scanner);
+extern void yyset_in(FILE * stream, yyscan_t scanner);
 
 /**
- * Bison main entry-point.
+ * Bison exported functions (declared in its header). The pull parser
+ * ("yyparse") drives the scanner by itself; the push parser ("yypush_parse")
+ * receives the tokens from the caller, one at a time.
  *
  * @see https://www.gnu.org/software/bison/manual/html_node/Parser-Function.html
+ * @see https://www.gnu.org/software/bison/manual/html_node/Push-Parser-Interface.html
  */
-extern int yyparse(void);
 
 // Bison error-reporting function.
-void yyerror(const char * string) {
-	LexicalAnalyzerContext * lexicalAnalyzerContext = createLexicalAnalyzerContext();
-	logError(_logger, "Syntax error (on line %d).", lexicalAnalyzerContext->line);
+void yyerror(yyscan_t scanner, CompilerState * compilerState, const char * string) {
+	const LexicalAnalyzerContext lexicalAnalyzerContext = createLexicalAnalyzerContext(scanner);
+	logError(_logger, "Syntax error (on line %d).", lexicalAnalyzerContext.line);
 }
 
-/* PUBLIC FUNCTIONS */
+/* PRIVATE FUNCTIONS */
 
-CompilerState * currentCompilerState() {
-	return _currentCompilerState;
+static SyntacticAnalysisStatus _createScanner(CompilerState * compilerState, SourceInput * sourceInput, yyscan_t * scanner);
+static SyntacticAnalysisStatus _syntacticAnalysisStatus(CompilerState * compilerState, const int code);
+
+/**
+ * Creates a scanner over the buffer of the program, scanned in place, or
+ * over its stream, read as it arrives (see "YY_INPUT" in "FlexPatterns.l").
+ */
+static SyntacticAnalysisStatus _createScanner(CompilerState * compilerState, SourceInput * sourceInput, yyscan_t * scanner) {
+	if (yylex_init_extra(compilerState, scanner) != 0) {
+		logError(_logger, "Cannot create the scanner: %s.", strerror(errno));
+		return OUT_OF_MEMORY;
+	}
+	if (sourceInput->stream != NULL) {
+		yyset_in(sourceInput->stream, *scanner);
+		return ACCEPT;
+	}
+	if (yy_scan_buffer(sourceInput->buffer, sourceInput->length + END_OF_BUFFER_MARKER_LENGTH, *scanner) == NULL) {
+		logError(_logger, "Flex rejects the buffer of the program.");
+		yylex_destroy(*scanner);
+		return UNKNOWN_ERROR;
+	}
+	return ACCEPT;
 }
 
-SyntacticAnalysisStatus parse(CompilerState * compilerState) {
-	logDebugging(_logger, "Parsing...");
-	_currentCompilerState = compilerState;
-	const int code = yyparse();
-	_currentCompilerState = NULL;
+/**
+ * Translates the exit code of Bison.
+ */
+static SyntacticAnalysisStatus _syntacticAnalysisStatus(CompilerState * compilerState, const int code) {
 	SyntacticAnalysisStatus syntacticAnalysisStatus;
-	logDebugging(_logger, "Parsing is done.");
 	switch (code) {
 		case 0:
 			if (compilerState->succeed == true) {
@@ -75,3 +98,80 @@ SyntacticAnalysisStatus parse(CompilerState * compilerState) {
 	compilerState->succeed = false;
 	return syntacticAnalysisStatus;
 }
+
+/* PUBLIC FUNCTIONS */
+
+SyntacticAnalysisStatus parse(CompilerState * compilerState, SourceInput * sourceInput) {
+	logDebugging(_logger, "Parsing...");
+	yyscan_t scanner = NULL;
+	const SyntacticAnalysisStatus scannerStatus = _createScanner(compilerState, sourceInput, &scanner);
+	if (scannerStatus != ACCEPT) {
+		return scannerStatus;
+	}
+	const int code = yyparse(scanner, compilerState);
+	yylex_destroy(scanner);
+	logDebugging(_logger, "Parsing is done.");
+	return _syntacticAnalysisStatus(compilerState, code);
+}
+
+/**
+ * The statement is reduced while its semicolon is pushed, without looking
+ * ahead (it's the only action of that state), so after the push the parser
+ * holds nothing allocated after the statement began, and it can be released.
+ */
+SyntacticAnalysisStatus parseStreaming(CompilerState * compilerState, SourceInput * sourceInput, StatementHandler handler, void * context) {
+	logDebugging(_logger, "Parsing in streaming mode...");
+	yyscan_t scanner = NULL;
+	const SyntacticAnalysisStatus scannerStatus = _createScanner(compilerState, sourceInput, &scanner);
+	if (scannerStatus != ACCEPT) {
+		return scannerStatus;
+	}
+	yypstate * parser = yypstate_new();
+	if (parser == NULL) {
+		logError(_logger, "Cannot create the parser.");
+		yylex_destroy(scanner);
+		return OUT_OF_MEMORY;
+	}
+
+	compilerState->streaming = true;
+	ArenaMark arenaMark = markArena(compilerState->arena);
+	uint32_t expressionMark = compilerState->expressions->count;
+	unsigned int statements = 0;
+	boolean aborted = false;
+	int code = YYPUSH_MORE;
+
+	while (code == YYPUSH_MORE) {
+		YYSTYPE semanticValue;
+		const int token = yylex(&semanticValue, scanner);
+		code = yypush_parse(parser, token, &semanticValue, scanner, compilerState);
+
+		Statement * statement = compilerState->streamedStatement;
+		if (statement == NULL) {
+			continue;
+		}
+		compilerState->streamedStatement = NULL;
+		++statements;
+		if (!handler(compilerState, statement, context)) {
+			aborted = true;
+			break;
+		}
+		if (statement->type == STATEMENT_ROUTINE) {
+			arenaMark = markArena(compilerState->arena);
+			expressionMark = compilerState->expressions->count;
+		}
+		else {
+			rewindArena(compilerState->arena, arenaMark);
+			truncateExpressionPool(compilerState->expressions, expressionMark);
+		}
+	}
+
+	yypstate_delete(parser);
+	yylex_destroy(scanner);
+	compilerState->streaming = false;
+	logDebugging(_logger, "Parsing is done (%u statements streamed).", statements);
+	if (aborted) {
+		compilerState->succeed = false;
+		return ABORTED;
+	}
+	return _syntacticAnalysisStatus(compilerState, code);
+}
@@ -3,11 +3,24 @@
 
 #include "../../shared/CompilerState.h"
 #include "../../shared/Logger.h"
+#include "../lexical-analysis/SourceInput.h"
+#include "AbstractSyntaxTree.h"
+
+/**
+ * The instance of a reentrant Flex scanner (the same definition that Flex
+ * provides).
+ */
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void * yyscan_t;
+#endif
 
 /** Bison imported functions. */
 
-int yylex(void);
-void yyerror(const char * string);
+union SemanticValue;
+
+int yylex(union SemanticValue * semanticValue, yyscan_t scanner);
+void yyerror(yyscan_t scanner, CompilerState * compilerState, const char * string);
 
 /** Initialize module's internal state. */
 void initializeSyntacticAnalyzerModule();
@@ -19,19 +32,31 @@ typedef enum {
 	ACCEPT,
 	OUT_OF_MEMORY,
 	REJECT,
-	UNKNOWN_ERROR
+	UNKNOWN_ERROR,
+
+	// The consumer of a streamed program stopped the parsing.
+	ABORTED
 } SyntacticAnalysisStatus;
 
 /**
- * Retrieves the current compiler state. The state must be accessed during the
- * parsing phase (i.e., during a call to the "parse" function). Outside of the
- * parse, the state is set to NULL.
+ * The consumer of the top-level statements of a streamed program. Returns
+ * false to stop the parsing.
+ */
+typedef boolean (* StatementHandler)(CompilerState * compilerState, Statement * statement, void * context);
+
+/**
+ * Executes the parsing phase of the compiler over a program. Every call uses
+ * its own scanner and parser, and the AST is stored in the compiler state, so
+ * many programs can be parsed at the same time (in different threads).
  */
-CompilerState * currentCompilerState();
+SyntacticAnalysisStatus parse(CompilerState * compilerState, SourceInput * sourceInput);
 
 /**
- * Executes the parsing phase of the compiler.
+ * Like "parse", but every top-level statement is handed over to a handler as
+ * soon as its semicolon is reduced, instead of being kept in the AST. Once
+ * handled, the memory of the statement is released (except for routines,
+ * which can be called later), so the AST never holds more than one of them.
  */
-SyntacticAnalysisStatus parse(CompilerState * compilerState);
+SyntacticAnalysisStatus parseStreaming(CompilerState * compilerState, SourceInput * sourceInput, StatementHandler handler, void * context);
 
 #endif
@@ -0,0 +1,135 @@
+#include "Arena.h"
+
+#define ARENA_ALIGNMENT				16
+#define INITIAL_BLOCK_SIZE			(64 * 1024)
+#define MAXIMUM_BLOCK_SIZE			(4 * 1024 * 1024)
+
+/* PRIVATE FUNCTIONS */
+
+static void * _allocate(Arena * arena, const size_t size, const uintptr_t alignment);
+static ArenaBlock * _createBlock(Arena * arena, const size_t size);
+
+/**
+ * Takes the next aligned chunk of the current block, or chains a new block
+ * if it doesn't fit.
+ */
+static void * _allocate(Arena * arena, const size_t size, const uintptr_t alignment) {
+	ArenaBlock * block = arena->current;
+	uintptr_t address = 0;
+
+	if (block != NULL) {
+		address = ((uintptr_t) (block->data + block->used) + alignment - 1) & ~(alignment - 1);
+	}
+	if (block == NULL || (uintptr_t) (block->data + block->capacity) < address + size) {
+		block = _createBlock(arena, size);
+		if (block == NULL) {
+			return NULL;
+		}
+		address = ((uintptr_t) block->data + alignment - 1) & ~(alignment - 1);
+	}
+
+	block->used = address + size - (uintptr_t) block->data;
+	arena->allocated += size;
+	return (void *) address;
+}
+
+/**
+ * Chains a new block big enough for the requested size. The size of the
+ * blocks grows geometrically, so huge inputs need only a few of them.
+ */
+static ArenaBlock * _createBlock(Arena * arena, const size_t size) {
+	size_t capacity = arena->blockSize;
+	if (capacity < size + ARENA_ALIGNMENT) {
+		capacity = size + ARENA_ALIGNMENT;
+	}
+
+	ArenaBlock * block = malloc(sizeof(ArenaBlock) + capacity);
+	if (block == NULL) {
+		return NULL;
+	}
+
+	block->previous = arena->current;
+	block->used = 0;
+	block->capacity = capacity;
+	arena->current = block;
+	if (arena->blockSize < MAXIMUM_BLOCK_SIZE) {
+		arena->blockSize *= 2;
+	}
+	return block;
+}
+
+/* PUBLIC FUNCTIONS */
+
+Arena * createArena() {
+	Arena * arena = calloc(1, sizeof(Arena));
+	if (arena != NULL) {
+		arena->blockSize = INITIAL_BLOCK_SIZE;
+	}
+	return arena;
+}
+
+void destroyArena(Arena * arena) {
+	if (arena != NULL) {
+		while (arena->current != NULL) {
+			ArenaBlock * previous = arena->current->previous;
+			free(arena->current);
+			arena->current = previous;
+		}
+		free(arena);
+	}
+}
+
+void * allocateInArena(Arena * arena, const size_t size) {
+	return _allocate(arena, size, ARENA_ALIGNMENT);
+}
+
+char * duplicateInArena(Arena * arena, const char * string, const size_t length) {
+	char * copy = _allocate(arena, length + 1, 1);
+	if (copy != NULL) {
+		memcpy(copy, string, length);
+		copy[length] = '\0';
+	}
+	return copy;
+}
+
+void resetArena(Arena * arena) {
+	if (arena->current == NULL) {
+		return;
+	}
+	while (arena->current->previous != NULL) {
+		ArenaBlock * previous = arena->current->previous;
+		free(arena->current);
+		arena->current = previous;
+	}
+	arena->current->used = 0;
+	arena->allocated = 0;
+}
+
+ArenaMark markArena(Arena * arena) {
+	ArenaMark mark = {
+		.block = arena->current,
+		.used = arena->current == NULL ? 0 : arena->current->used,
+		.allocated = arena->allocated
+	};
+	return mark;
+}
+
+void rewindArena(Arena * arena, const ArenaMark mark) {
+	if (arena->current == mark.block) {
+		if (arena->current != NULL) {
+			arena->current->used = mark.used;
+		}
+	}
+	else {
+		while (arena->current->previous != mark.block) {
+			ArenaBlock * previous = arena->current->previous;
+			free(arena->current);
+			arena->current = previous;
+		}
+		arena->current->used = 0;
+		if (mark.block != NULL) {
+			mark.block->used = mark.used;
+		}
+	}
+	arena->allocated = mark.allocated;
+}
@@ -0,0 +1,83 @@
+#ifndef ARENA_HEADER
+#define ARENA_HEADER
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * A block of memory of an arena. Blocks are chained from the newest to the
+ * oldest one.
+ */
+typedef struct ArenaBlock ArenaBlock;
+
+struct ArenaBlock {
+	ArenaBlock * previous;
+	size_t used;
+	size_t capacity;
+	char data[];
+};
+
+/**
+ * A bump allocator: memory is taken sequentially from large blocks, and it
+ * can only be released all at once. Useful for data with the same lifetime,
+ * like the nodes of the AST of a compilation.
+ */
+typedef struct {
+	ArenaBlock * current;
+	size_t blockSize;
+
+	// The amount of bytes requested so far (for statistics).
+	size_t allocated;
+} Arena;
+
+/**
+ * A position of an arena, to release every allocation made after it.
+ */
+typedef struct {
+	ArenaBlock * block;
+	size_t used;
+	size_t allocated;
+} ArenaMark;
+
+/**
+ * Creates a new arena. The first block is allocated lazily.
+ */
+Arena * createArena();
+
+/**
+ * Destroy an arena and every allocation made from it.
+ */
+void destroyArena(Arena * arena);
+
+/**
+ * Allocates uninitialized memory from the arena, aligned for any type.
+ * Returns NULL if the system runs out of memory.
+ */
+void * allocateInArena(Arena * arena, const size_t size);
+
+/**
+ * Copies the first "length" characters of a string into the arena, and adds
+ * a null-terminator.
+ */
+char * duplicateInArena(Arena * arena, const char * string, const size_t length);
+
+/**
+ * Releases every allocation made from the arena at once, but keeps its
+ * first block for reuse.
+ */
+void resetArena(Arena * arena);
+
+/**
+ * Gets the current position of an arena.
+ */
+ArenaMark markArena(Arena * arena);
+
+/**
+ * Releases every allocation made since a mark was taken. The first block
+ * chained after the mark (if any) is kept for reuse, so rewinding over and
+ * over never goes back to the system.
+ */
+void rewindArena(Arena * arena, const ArenaMark mark);
+
+#endif
@@ -1,7 +1,10 @@
 #ifndef COMPILER_STATE_HEADER
 #define COMPILER_STATE_HEADER
 
+#include "Arena.h"
+#include "Interner.h"
 #include "Type.h"
+#include <stdio.h>
 
 /**
  * The general status of a compilation.
@@ -19,6 +22,23 @@ typedef struct {
 	// The root node of the AST.
 	void * abstractSyntaxtTree;
 
+	// The memory of the AST nodes and their lexemes. Released all at once.
+	Arena * arena;
+
+	// The expressions of the AST (an "ExpressionPool"), addressed by index.
+	struct ExpressionPool * expressions;
+
+	// The unique copy of every identifier and literal of the program.
+	Interner * interner;
+
+	// The stream where the program writes its output.
+	FILE * output;
+
+	// In streaming mode, the top-level statements are not kept in the AST:
+	// each one is handed over here (a "Statement"), as soon as it's parsed.
+	boolean streaming;
+	void * streamedStatement;
+
 	// A flag that indicates the current state of the compilation so far.
 	boolean succeed;
 
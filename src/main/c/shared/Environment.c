@@ -15,6 +15,19 @@ const boolean getBooleanOrDefault(const char * name, const boolean defaultValue)
 	}
 }
 
+const size_t getIntegerOrDefault(const char * name, const size_t defaultValue) {
+	const char * value = getStringOrDefault(name, NULL);
+	if (value == NULL || *value == '\0') {
+		return defaultValue;
+	}
+	char * end = NULL;
+	const unsigned long long integer = strtoull(value, &end, 10);
+	if (*end != '\0' || *value == '-') {
+		return defaultValue;
+	}
+	return (size_t) integer;
+}
+
 const char * getStringOrDefault(const char * name, const char * defaultValue) {
 	const char * value = getenv(name);
 	if (value == NULL) {
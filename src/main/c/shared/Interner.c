@@ -0,0 +1,143 @@
+#include "Interner.h"
+
+#define INITIAL_INDEX_CAPACITY			1024
+
+/**
+ * A bucket of the open-addressing index. The hash and the length are cached,
+ * so most of the probes never touch the characters.
+ */
+typedef struct {
+	uint32_t hash;
+	uint32_t length;
+	const char * string;
+} InternedEntry;
+
+struct Interner {
+	InternedEntry * index;
+	size_t indexCapacity;
+
+	// The storage of the characters of the unique strings.
+	Arena * strings;
+
+	InternerStatistics statistics;
+};
+
+/* PRIVATE FUNCTIONS */
+
+static boolean _expandIndex(Interner * interner);
+static uint32_t _hash(const char * string, const size_t length);
+
+/**
+ * Doubles the capacity of the index, keeping the load factor under 1/2.
+ */
+static boolean _expandIndex(Interner * interner) {
+	const size_t capacity = 2 * interner->indexCapacity;
+	const size_t mask = capacity - 1;
+	InternedEntry * index = calloc(capacity, sizeof(InternedEntry));
+	if (index == NULL) {
+		return false;
+	}
+
+	for (size_t k = 0; k < interner->indexCapacity; ++k) {
+		const InternedEntry * entry = &interner->index[k];
+		if (entry->string == NULL) {
+			continue;
+		}
+		size_t bucket = entry->hash & mask;
+		while (index[bucket].string != NULL) {
+			bucket = (bucket + 1) & mask;
+		}
+		index[bucket] = *entry;
+	}
+
+	free(interner->index);
+	interner->index = index;
+	interner->indexCapacity = capacity;
+	return true;
+}
+
+/**
+ * FNV-1a hash function.
+ *
+ * @see http://www.isthe.com/chongo/tech/comp/fnv/index.html
+ */
+static uint32_t _hash(const char * string, const size_t length) {
+	uint32_t hash = 2166136261u;
+	for (size_t k = 0; k < length; ++k) {
+		hash ^= (unsigned char) string[k];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/* PUBLIC FUNCTIONS */
+
+Interner * createInterner() {
+	Interner * interner = calloc(1, sizeof(Interner));
+	if (interner == NULL) {
+		return NULL;
+	}
+	interner->indexCapacity = INITIAL_INDEX_CAPACITY;
+	interner->index = calloc(interner->indexCapacity, sizeof(InternedEntry));
+	interner->strings = createArena();
+	if (interner->index == NULL || interner->strings == NULL) {
+		destroyInterner(interner);
+		return NULL;
+	}
+	return interner;
+}
+
+void destroyInterner(Interner * interner) {
+	if (interner != NULL) {
+		destroyArena(interner->strings);
+		free(interner->index);
+		free(interner);
+	}
+}
+
+const char * intern(Interner * interner, const char * string, const size_t length) {
+	InternerStatistics * statistics = &interner->statistics;
+	statistics->requests++;
+	statistics->requestedBytes += length + 1;
+
+	const uint32_t hash = _hash(string, length);
+	const size_t mask = interner->indexCapacity - 1;
+	size_t bucket = hash & mask;
+	for (; interner->index[bucket].string != NULL; bucket = (bucket + 1) & mask) {
+		const InternedEntry * entry = &interner->index[bucket];
+		if (entry->hash == hash && entry->length == length && memcmp(entry->string, string, length) == 0) {
+			return entry->string;
+		}
+	}
+
+	// An empty bucket always ends the probes, even if the index cannot grow.
+	if (interner->indexCapacity <= statistics->strings + 1) {
+		return NULL;
+	}
+	const char * copy = duplicateInArena(interner->strings, string, length);
+	if (copy == NULL) {
+		return NULL;
+	}
+	interner->index[bucket] = (InternedEntry) {
+		.hash = hash,
+		.length = length,
+		.string = copy
+	};
+	statistics->strings++;
+	statistics->storedBytes += length + 1;
+
+	// If the index cannot grow, the copy is stored anyway (the next string
+	// tries again).
+	if (interner->indexCapacity < 2 * statistics->strings) {
+		_expandIndex(interner);
+	}
+	return copy;
+}
+
+const char * internString(Interner * interner, const char * string) {
+	return intern(interner, string, strlen(string));
+}
+
+InternerStatistics getInternerStatistics(const Interner * interner) {
+	return interner->statistics;
+}
@@ -0,0 +1,59 @@
+#ifndef INTERNER_HEADER
+#define INTERNER_HEADER
+
+#include "Arena.h"
+#include "Type.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * A pool of unique strings. Interning the same characters twice returns the
+ * same pointer, so interned strings can be compared by identity, and every
+ * identifier or literal has a single copy, shared by all of the phases of a
+ * compilation. The strings are immutable, and they live until the interner
+ * is destroyed.
+ */
+typedef struct Interner Interner;
+
+/**
+ * The usage of an interner (for statistics).
+ */
+typedef struct {
+	// The amount of strings (and their bytes) requested to be interned.
+	size_t requests;
+	size_t requestedBytes;
+
+	// The amount of unique strings (and their bytes) actually stored.
+	size_t strings;
+	size_t storedBytes;
+} InternerStatistics;
+
+/**
+ * Creates an empty interner. Returns NULL if the system runs out of memory.
+ */
+Interner * createInterner();
+
+/**
+ * Destroy an interner and every string interned in it.
+ */
+void destroyInterner(Interner * interner);
+
+/**
+ * Returns the unique copy of the first "length" characters of a string (that
+ * doesn't need to be null-terminated), storing it the first time. The copy is
+ * null-terminated. Returns NULL if the system runs out of memory.
+ */
+const char * intern(Interner * interner, const char * string, const size_t length);
+
+/**
+ * Returns the unique copy of a null-terminated string.
+ */
+const char * internString(Interner * interner, const char * string);
+
+/**
+ * Gets the usage of an interner so far.
+ */
+InternerStatistics getInternerStatistics(const Interner * interner);
+
+#endif
@@ -1,28 +1,159 @@
 #include "Logger.h"
 
+#define LOG_RECORD_COUNT				4096
+#define LOG_RECORD_MASK					(LOG_RECORD_COUNT - 1)
+#define LOG_NAME_SIZE					32
+#define LOG_MESSAGE_SIZE				472
+#define WRITER_IDLE_NANOSECONDS			100000
+#define WRITER_SPINS					64
+
+/* MODULE INTERNAL STATE */
+
+static boolean _asynchronous = false;
+
+#ifdef ASYNCHRONOUS_LOGGING
+/**
+ * A slot of the ring. The message is formatted by the producer (because the
+ * arguments don't outlive the call), but the context, the name of the logger
+ * and the output itself are handled by the writer thread. The sequence tells
+ * whether the slot is free, or ready to be written.
+ *
+ * @see https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+ */
+typedef struct {
+	size_t sequence;
+	LoggingLevel loggingLevel;
+	char name[LOG_NAME_SIZE];
+	char message[LOG_MESSAGE_SIZE];
+} LogRecord;
+
+static LogRecord * _ring = NULL;
+static size_t _tail = 0;
+static size_t _head = 0;
+static size_t _dropped = 0;
+static boolean _running = false;
+static pthread_t _writer;
+#endif
+
 /* PRIVATE FUNCTIONS */
 
 static void _log(const Logger * logger, const LoggingLevel loggingLevel, const char * const format, va_list arguments);
 static LoggingLevel _loggingLevelFromString(const char * loggingLevel);
-static void _logInStream(FILE * const stream, const char * const format, va_list arguments);
+static void _logInStream(FILE * const stream, const Logger * logger, const LoggingLevel loggingLevel, const char * const format, va_list arguments);
 static const char * _toContextString(const LoggingLevel loggingLevel);
+#ifdef ASYNCHRONOUS_LOGGING
+static void _enqueue(const Logger * logger, const LoggingLevel loggingLevel, const char * const format, va_list arguments);
+static boolean _dequeue();
+static void * _write(void * unused);
+#endif
 
 /**
  * Logs a new message at the specified level, using a format string.
  */
 static void _log(const Logger * logger, const LoggingLevel loggingLevel, const char * const format, va_list arguments) {
 	if (logger->loggingLevel <= loggingLevel) {
-		const char * context = _toContextString(loggingLevel);
-		char * effectiveFormat = concatenate(6, context, "[", logger->name, "] ", format, "\n");
+#ifdef ASYNCHRONOUS_LOGGING
+		if (_asynchronous) {
+			_enqueue(logger, loggingLevel, format, arguments);
+			return;
+		}
+#endif
 		if (ERROR <= loggingLevel) {
-			_logInStream(stderr, effectiveFormat, arguments);
+			_logInStream(stderr, logger, loggingLevel, format, arguments);
+		}
+		else {
+			_logInStream(stdout, logger, loggingLevel, format, arguments);
+		}
+	}
+}
+
+#ifdef ASYNCHRONOUS_LOGGING
+/**
+ * Claims the next free slot of the ring, formats the message into it, and
+ * publishes it to the writer. It never blocks: if the ring is full, the
+ * record is dropped (and counted).
+ */
+static void _enqueue(const Logger * logger, const LoggingLevel loggingLevel, const char * const format, va_list arguments) {
+	size_t position = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+	LogRecord * record = NULL;
+	for (;;) {
+		record = &_ring[position & LOG_RECORD_MASK];
+		const size_t sequence = __atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE);
+		const intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+		if (difference == 0) {
+			if (__atomic_compare_exchange_n(&_tail, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		}
+		else if (difference < 0) {
+			__atomic_fetch_add(&_dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}
+		else {
+			position = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+		}
+	}
+
+	record->loggingLevel = loggingLevel;
+	strncpy(record->name, logger->name, LOG_NAME_SIZE - 1);
+	record->name[LOG_NAME_SIZE - 1] = '\0';
+	vsnprintf(record->message, LOG_MESSAGE_SIZE, format, arguments);
+	__atomic_store_n(&record->sequence, position + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Writes the oldest published record, and releases its slot. Returns false
+ * if there is none. Only the writer thread consumes the ring.
+ */
+static boolean _dequeue() {
+	LogRecord * record = &_ring[_head & LOG_RECORD_MASK];
+	if (__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) != _head + 1) {
+		return false;
+	}
+	FILE * stream = ERROR <= record->loggingLevel ? stderr : stdout;
+	fprintf(stream, "%s[%s] %s\n", _toContextString(record->loggingLevel), record->name, record->message);
+	__atomic_store_n(&record->sequence, _head + LOG_RECORD_COUNT, __ATOMIC_RELEASE);
+	++_head;
+	return true;
+}
+
+/**
+ * The writer thread: drains the ring, flushing the streams only when it
+ * runs out of records. While the ring is empty, it yields for a while, and
+ * then it sleeps. After the shutdown, it drains every record left.
+ */
+static void * _write(void * unused) {
+	const struct timespec idle = {
+		.tv_sec = 0,
+		.tv_nsec = WRITER_IDLE_NANOSECONDS
+	};
+	unsigned int spins = 0;
+	for (;;) {
+		const boolean running = __atomic_load_n(&_running, __ATOMIC_ACQUIRE);
+		boolean written = false;
+		while (_dequeue()) {
+			written = true;
+		}
+		if (written) {
+			fflush(stdout);
+			fflush(stderr);
+		}
+		if (!running) {
+			return NULL;
+		}
+		if (written) {
+			spins = 0;
+		}
+		else if (spins < WRITER_SPINS) {
+			++spins;
+			sched_yield();
 		}
 		else {
-			_logInStream(stdout, effectiveFormat, arguments);
+			nanosleep(&idle, NULL);
 		}
-		free(effectiveFormat);
 	}
 }
+#endif
 
 /**
  * Gets the logging level from the specified string. Returns CRITICAL if the
@@ -38,12 +169,15 @@ static LoggingLevel _loggingLevelFromString(const char * loggingLevel) {
 }
 
 /**
- * Low-level logging function.
+ * Low-level logging function. The context and the name are written apart
+ * from the message, so no format string has to be built.
  *
  * @see https://cplusplus.com/reference/cstdio/vfprintf/
  */
-static void _logInStream(FILE * const stream, const char * const format, va_list arguments) {
+static void _logInStream(FILE * const stream, const Logger * logger, const LoggingLevel loggingLevel, const char * const format, va_list arguments) {
+	fprintf(stream, "%s[%s] ", _toContextString(loggingLevel), logger->name);
 	vfprintf(stream, format, arguments);
+	fputc('\n', stream);
 }
 
 /**
@@ -68,6 +202,48 @@ static const char * _toContextString(const LoggingLevel loggingLevel) {
 
 /* PUBLIC FUNCTIONS */
 
+void initializeLoggerModule() {
+	if (strcmp(getStringOrDefault("LOGGING_MODE", "SYNCHRONOUS"), "ASYNCHRONOUS") != 0) {
+		return;
+	}
+#ifdef ASYNCHRONOUS_LOGGING
+	_ring = malloc(LOG_RECORD_COUNT * sizeof(LogRecord));
+	if (_ring == NULL) {
+		return;
+	}
+	for (size_t k = 0; k < LOG_RECORD_COUNT; ++k) {
+		_ring[k].sequence = k;
+	}
+	_tail = 0;
+	_head = 0;
+	_dropped = 0;
+	_running = true;
+	if (pthread_create(&_writer, NULL, _write, NULL) != 0) {
+		free(_ring);
+		_ring = NULL;
+		return;
+	}
+	_asynchronous = true;
+#endif
+}
+
+void shutdownLoggerModule() {
+#ifdef ASYNCHRONOUS_LOGGING
+	if (!_asynchronous) {
+		return;
+	}
+	__atomic_store_n(&_running, false, __ATOMIC_RELEASE);
+	pthread_join(_writer, NULL);
+	_asynchronous = false;
+	const size_t dropped = __atomic_load_n(&_dropped, __ATOMIC_RELAXED);
+	if (0 < dropped) {
+		fprintf(stderr, "%s[Logger] %zu log records were dropped (the ring was full).\n", _toContextString(WARNING), dropped);
+	}
+	free(_ring);
+	_ring = NULL;
+#endif
+}
+
 Logger * createLogger(char * name) {
 	Logger * logger = calloc(1, sizeof(Logger));
 	logger->loggingLevel = _loggingLevelFromString(getStringOrDefault("LOGGING_LEVEL", "INFORMATION"));
@@ -85,37 +261,9 @@ void destroyLogger(Logger * logger) {
 	}
 }
 
-void logCritical(const Logger * logger, const char * const format, ...) {
-	va_list arguments;
-	va_start(arguments, format);
-	_log(logger, CRITICAL, format, arguments);
-	va_end(arguments);
-}
-
-void logDebugging(const Logger * logger, const char * const format, ...) {
-	va_list arguments;
-	va_start(arguments, format);
-	_log(logger, DEBUGGING, format, arguments);
-	va_end(arguments);
-}
-
-void logError(const Logger * logger, const char * const format, ...) {
-	va_list arguments;
-	va_start(arguments, format);
-	_log(logger, ERROR, format, arguments);
-	va_end(arguments);
-}
-
-void logInformation(const Logger * logger, const char * const format, ...) {
-	va_list arguments;
-	va_start(arguments, format);
-	_log(logger, INFORMATION, format, arguments);
-	va_end(arguments);
-}
-
-void logWarning(const Logger * logger, const char * const format, ...) {
+void logMessage(const Logger * logger, const LoggingLevel loggingLevel, const char * const format, ...) {
 	va_list arguments;
 	va_start(arguments, format);
-	_log(logger, WARNING, format, arguments);
+	_log(logger, loggingLevel, format, arguments);
 	va_end(arguments);
 }
@@ -7,6 +7,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+/**
+ * The asynchronous mode needs POSIX threads, and the atomic built-ins of GCC
+ * and Clang. Otherwise, the logging is always synchronous.
+ *
+ * @see https://gcc.gnu.org/onlinedocs/gcc/_005f_005fatomic-Builtins.html
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(_WIN32)
+#define ASYNCHRONOUS_LOGGING
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
 /**
  * Platform dependent macros.
  *
@@ -75,6 +88,20 @@ typedef struct {
 	char * name;
 } Logger;
 
+/**
+ * Initialize module's internal state. If the "LOGGING_MODE" environment
+ * variable is "ASYNCHRONOUS", the messages are queued in a bounded lock-free
+ * ring and written by a background thread (when the ring is full, the
+ * messages are dropped and counted). Otherwise, they are written right away.
+ */
+void initializeLoggerModule();
+
+/**
+ * Shutdown module's internal state. Waits until every queued message is
+ * written, and reports how many were dropped.
+ */
+void shutdownLoggerModule();
+
 /**
  * Creates a new logger with the specified name. That name will be visible in
  * every line you log with this object.
@@ -86,19 +113,52 @@ Logger * createLogger(char * name);
  */
 void destroyLogger(Logger * logger);
 
+/**
+ * The minimum logging level compiled into the application (see the
+ * "MINIMUM_LOGGING_LEVEL" option in CMake). Every log below it is removed by
+ * the compiler, no matter the level of the logger at runtime.
+ */
+#ifndef MINIMUM_LOGGING_LEVEL
+#define MINIMUM_LOGGING_LEVEL ALL
+#endif
+
+/**
+ * Whether a logger would log a message at the specified level. It's cheap
+ * enough to guard the computation of expensive arguments.
+ */
+#define isLoggable(logger, level) \
+	(MINIMUM_LOGGING_LEVEL <= (level) && (logger)->loggingLevel <= (level))
+
+/**
+ * Logs a message at the specified level, but only if the logger accepts it.
+ * Otherwise, the arguments are not even evaluated.
+ */
+#define logAtLevel(logger, level, ...) \
+	do { \
+		if (isLoggable(logger, level)) { \
+			logMessage(logger, level, __VA_ARGS__); \
+		} \
+	} while (0)
+
 /** Logs at CRITICAL level. */
-void logCritical(const Logger * logger, const char * const format, ...);
+#define logCritical(logger, ...) logAtLevel(logger, CRITICAL, __VA_ARGS__)
 
 /** Logs at DEBUGGING level. */
-void logDebugging(const Logger * logger, const char * const format, ...);
+#define logDebugging(logger, ...) logAtLevel(logger, DEBUGGING, __VA_ARGS__)
 
 /** Logs at ERROR level. */
-void logError(const Logger * logger, const char * const format, ...);
+#define logError(logger, ...) logAtLevel(logger, ERROR, __VA_ARGS__)
 
 /** Logs at INFORMATION level. */
-void logInformation(const Logger * logger, const char * const format, ...);
+#define logInformation(logger, ...) logAtLevel(logger, INFORMATION, __VA_ARGS__)
 
 /** Logs at WARNING level. */
-void logWarning(const Logger * logger, const char * const format, ...);
+#define logWarning(logger, ...) logAtLevel(logger, WARNING, __VA_ARGS__)
+
+/**
+ * Logs a message at the specified level, using a format string. Prefer the
+ * macros above, because this function always evaluates its arguments.
+ */
+void logMessage(const Logger * logger, const LoggingLevel loggingLevel, const char * const format, ...);
 
 #endif
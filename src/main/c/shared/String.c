@@ -3,6 +3,9 @@
 /* PRIVATE FUNCTIONS */
 
 static const char * _controlCharacterToEscapedString(const char character);
+static unsigned int _height(const String * string);
+static String _node(String left, String right);
+static String _join(String left, String right);
 
 /**
  * Returns a read-only string that represents the escaped sequence of the
@@ -48,8 +51,295 @@ static const char * _controlCharacterToEscapedString(const char character) {
 	}
 }
 
+/**
+ * The height of a string in a rope (zero if it's flat).
+ */
+static unsigned int _height(const String * string) {
+	return string->rope ? string->node->height : 0;
+}
+
+/**
+ * Creates a node over two strings (taking their ownership), without
+ * balancing it. An empty operand is just dropped, and two short ones are
+ * copied into a single buffer, so every rope is longer than
+ * ROPE_LEAF_CAPACITY.
+ */
+static String _node(String left, String right) {
+	if (left.length == 0 || right.length == 0) {
+		return left.length == 0 ? right : left;
+	}
+	if (left.length + right.length <= ROPE_LEAF_CAPACITY) {
+		// Both are flat, since every rope is longer.
+		String result = { 0 };
+		char * destiny = allocateString(&result, left.length + right.length);
+		if (destiny != NULL) {
+			memcpy(destiny, getCharacters(&left), left.length);
+			memcpy(destiny + left.length, getCharacters(&right), right.length);
+			result.ascii = left.ascii && right.ascii;
+		}
+		destroyString(&left);
+		destroyString(&right);
+		return result;
+	}
+	StringNode * node = malloc(sizeof(StringNode));
+	if (node == NULL) {
+		destroyString(&left);
+		destroyString(&right);
+		return (String) { 0 };
+	}
+	const unsigned int leftHeight = _height(&left);
+	const unsigned int rightHeight = _height(&right);
+	node->references = 1;
+	node->height = 1 + (leftHeight < rightHeight ? rightHeight : leftHeight);
+	node->left = left;
+	node->right = right;
+	return (String) {
+		.length = left.length + right.length,
+		.ascii = left.ascii && right.ascii,
+		.rope = true,
+		.node = node
+	};
+}
+
+/**
+ * Joins two balanced ropes (taking their ownership) into a balanced one: the
+ * shorter one is joined along the spine of the taller one, and the path is
+ * rebuilt with rotations, like in an AVL tree. The nodes are shared, so they
+ * are never modified. A short piece is merged with its neighbour leaf, so
+ * the leaves don't get too small.
+ */
+static String _join(String left, String right) {
+	if (left.length == 0 || right.length == 0 || left.length + right.length <= ROPE_LEAF_CAPACITY) {
+		return _node(left, right);
+	}
+
+	const unsigned int leftHeight = _height(&left);
+	const unsigned int rightHeight = _height(&right);
+	// A short leaf is merged with the nearest leaf of the other side.
+	if (leftHeight == 1 && !right.rope && left.node->right.length + right.length <= ROPE_LEAF_CAPACITY) {
+		String outer = copyString(&left.node->left);
+		String inner = _join(copyString(&left.node->right), right);
+		destroyString(&left);
+		return _node(outer, inner);
+	}
+	if (rightHeight == 1 && !left.rope && left.length + right.node->left.length <= ROPE_LEAF_CAPACITY) {
+		String inner = _join(left, copyString(&right.node->left));
+		String outer = copyString(&right.node->right);
+		destroyString(&right);
+		return _node(inner, outer);
+	}
+
+	if (rightHeight + 1 < leftHeight) {
+		String outer = copyString(&left.node->left);
+		String inner = _join(copyString(&left.node->right), right);
+		destroyString(&left);
+		if (_height(&inner) <= _height(&outer) + 1) {
+			return _node(outer, inner);
+		}
+		String a = copyString(&inner.node->left);
+		String b = copyString(&inner.node->right);
+		destroyString(&inner);
+		if (_height(&a) <= _height(&b)) {
+			return _node(_node(outer, a), b);
+		}
+		String c = copyString(&a.node->left);
+		String d = copyString(&a.node->right);
+		destroyString(&a);
+		return _node(_node(outer, c), _node(d, b));
+	}
+	if (leftHeight + 1 < rightHeight) {
+		String inner = _join(left, copyString(&right.node->left));
+		String outer = copyString(&right.node->right);
+		destroyString(&right);
+		if (_height(&inner) <= _height(&outer) + 1) {
+			return _node(inner, outer);
+		}
+		String a = copyString(&inner.node->left);
+		String b = copyString(&inner.node->right);
+		destroyString(&inner);
+		if (_height(&b) <= _height(&a)) {
+			return _node(a, _node(b, outer));
+		}
+		String c = copyString(&b.node->left);
+		String d = copyString(&b.node->right);
+		destroyString(&b);
+		return _node(_node(a, c), _node(d, outer));
+	}
+	return _node(left, right);
+}
+
 /* PUBLIC FUNCTIONS */
 
+String createString(const char * characters, const size_t length) {
+	String string = { 0 };
+	char * destiny = allocateString(&string, length);
+	if (destiny != NULL) {
+		memcpy(destiny, characters, length);
+		string.ascii = isAscii(characters, length);
+	}
+	return string;
+}
+
+char * allocateString(String * string, const size_t length) {
+	string->ascii = false;
+	string->rope = false;
+	if (length <= SHORT_STRING_CAPACITY) {
+		string->length = length;
+		string->shortCharacters[length] = '\0';
+		return string->shortCharacters;
+	}
+	StringBuffer * buffer = malloc(sizeof(StringBuffer) + length + 1);
+	if (buffer == NULL) {
+		string->length = 0;
+		string->shortCharacters[0] = '\0';
+		return NULL;
+	}
+	buffer->capacity = length;
+	buffer->references = 1;
+	buffer->characters[length] = '\0';
+	string->length = length;
+	string->buffer = buffer;
+	return buffer->characters;
+}
+
+char * resizeString(String * string, const size_t length) {
+	string->ascii = false;
+	if (string->length <= SHORT_STRING_CAPACITY) {
+		if (length <= SHORT_STRING_CAPACITY) {
+			string->length = length;
+			string->shortCharacters[length] = '\0';
+			return string->shortCharacters;
+		}
+		String resized = { 0 };
+		char * destiny = allocateString(&resized, length);
+		if (destiny != NULL) {
+			memcpy(destiny, string->shortCharacters, string->length);
+		}
+		*string = resized;
+		return destiny;
+	}
+	StringBuffer * buffer = string->buffer;
+	if (length <= SHORT_STRING_CAPACITY) {
+		memcpy(string->shortCharacters, buffer->characters, length);
+		string->shortCharacters[length] = '\0';
+		string->length = length;
+		free(buffer);
+		return string->shortCharacters;
+	}
+	// Only a buffer that is too small, or too big (twice the length), moves.
+	if (buffer->capacity < length || 2 * length < buffer->capacity) {
+		buffer = realloc(buffer, sizeof(StringBuffer) + length + 1);
+		if (buffer == NULL) {
+			free(string->buffer);
+			*string = (String) { 0 };
+			return NULL;
+		}
+		buffer->capacity = length;
+		string->buffer = buffer;
+	}
+	buffer->characters[length] = '\0';
+	string->length = length;
+	return buffer->characters;
+}
+
+char * detachString(String * string) {
+	StringBuffer * shared = string->buffer;
+	const boolean ascii = string->ascii;
+	char * destiny = allocateString(string, string->length);
+	if (destiny != NULL) {
+		memcpy(destiny, shared->characters, string->length);
+		string->ascii = ascii;
+	}
+	--shared->references;
+	return destiny;
+}
+
+boolean flattenString(String * string) {
+	if (!string->rope) {
+		return true;
+	}
+	String flat = { 0 };
+	char * destiny = allocateString(&flat, string->length);
+	if (destiny != NULL) {
+		copyCharacters(string, destiny);
+		flat.ascii = string->ascii;
+	}
+	destroyString(string);
+	*string = flat;
+	return destiny != NULL;
+}
+
+String copyString(const String * string) {
+	if (string->rope) {
+		++string->node->references;
+	}
+	else if (SHORT_STRING_CAPACITY < string->length) {
+		++string->buffer->references;
+	}
+	return *string;
+}
+
+String concatenateStrings(String * left, String * right) {
+	String result = _join(*left, *right);
+	*left = (String) { 0 };
+	*right = (String) { 0 };
+	return result;
+}
+
+char * copyCharacters(const String * string, char * destiny) {
+	if (string->rope) {
+		destiny = copyCharacters(&string->node->left, destiny);
+		return copyCharacters(&string->node->right, destiny);
+	}
+	memcpy(destiny, getCharacters(string), string->length);
+	return destiny + string->length;
+}
+
+void visitString(const String * string, StringVisitor visitor, void * context) {
+	if (string->rope) {
+		visitString(&string->node->left, visitor, context);
+		visitString(&string->node->right, visitor, context);
+	}
+	else if (0 < string->length) {
+		visitor(getCharacters(string), string->length, context);
+	}
+}
+
+void destroyString(String * string) {
+	if (string->rope) {
+		StringNode * node = string->node;
+		if (--node->references == 0) {
+			destroyString(&node->left);
+			destroyString(&node->right);
+			free(node);
+		}
+	}
+	else if (SHORT_STRING_CAPACITY < string->length && --string->buffer->references == 0) {
+		free(string->buffer);
+	}
+	string->length = 0;
+	string->ascii = false;
+	string->rope = false;
+	string->shortCharacters[0] = '\0';
+}
+
+/**
+ * Checks a word at a time while it's possible.
+ */
+boolean isAscii(const char * characters, const size_t length) {
+	size_t k = 0;
+	uint64_t bits = 0;
+	for (; k + sizeof(uint64_t) <= length; k += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, characters + k, sizeof(word));
+		bits |= word;
+	}
+	for (; k < length; ++k) {
+		bits |= (unsigned char) characters[k];
+	}
+	return (bits & 0x8080808080808080ull) == 0;
+}
+
 char * concatenate(const unsigned int count, ...) {
 	va_list arguments;
 	va_start(arguments, count);
@@ -70,26 +360,29 @@ char * concatenate(const unsigned int count, ...) {
 }
 
 char * escape(const char * string) {
-	unsigned int length = 1;
-	for (unsigned int k = 0; 0 < string[k]; ++k) {
-		if (iscntrl(string[k])) {
-			length += strlen(_controlCharacterToEscapedString(string[k]));
-		}
-		else {
-			length += 1;
-		}
+	return escapeSubstring(string, strlen(string));
+}
+
+char * escapeSubstring(const char * string, const size_t length) {
+	size_t escapedLength = 1;
+	for (size_t k = 0; k < length; ++k) {
+		const char * escapedSequence = _controlCharacterToEscapedString(string[k]);
+		escapedLength += escapedSequence == NULL ? 1 : strlen(escapedSequence);
 	}
-	char * escapedString = calloc(length, sizeof(char));
-	char charToString[2] = { 0, 0 };
-	for (unsigned int k = 0; 0 < string[k]; ++k) {
-		if (iscntrl(string[k])) {
-			strcat(escapedString, _controlCharacterToEscapedString(string[k]));
+	char * escapedString = malloc(escapedLength);
+	char * destiny = escapedString;
+	for (size_t k = 0; k < length; ++k) {
+		const char * escapedSequence = _controlCharacterToEscapedString(string[k]);
+		if (escapedSequence == NULL) {
+			*destiny++ = string[k];
 		}
 		else {
-			charToString[0] = string[k];
-			strcat(escapedString, charToString);
+			const size_t bytes = strlen(escapedSequence);
+			memcpy(destiny, escapedSequence, bytes);
+			destiny += bytes;
 		}
 	}
+	*destiny = '\0';
 	return escapedString;
 }
 
@@ -1,11 +1,172 @@
 #ifndef STRING_HEADER
 #define STRING_HEADER
 
+#include "Type.h"
 #include <ctype.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+/** The longest string stored inline, without heap-memory. */
+#define SHORT_STRING_CAPACITY		23
+
+/**
+ * The longest concatenation that is copied into a single buffer. The longer
+ * ones share their operands in a rope, instead.
+ */
+#define ROPE_LEAF_CAPACITY			256
+
+/**
+ * The heap-memory of a long string: its capacity (without the final null
+ * character), the number of strings that share it, and its characters. The
+ * count is not atomic, since a string belongs to a single virtual machine.
+ */
+typedef struct {
+	size_t capacity;
+	size_t references;
+	char characters[];
+} StringBuffer;
+
+typedef struct StringNode StringNode;
+
+/**
+ * A length-prefixed string, with cached metadata. The short ones are stored
+ * inline, so they never use heap-memory, and the long ones in a buffer,
+ * which is shared by its copies until one of them is modified. A long
+ * concatenation is a rope instead (a tree of shared strings), which has no
+ * contiguous characters until it's flattened. The characters are
+ * null-terminated too, and a zeroed string is empty.
+ */
+typedef struct {
+	size_t length;
+
+	// Whether every character is known to be ASCII (false if it's unknown).
+	boolean ascii;
+
+	// Whether it's a rope (always longer than ROPE_LEAF_CAPACITY).
+	boolean rope;
+
+	union {
+		StringBuffer * buffer;
+		StringNode * node;
+		char shortCharacters[SHORT_STRING_CAPACITY + 1];
+	};
+} String;
+
+/**
+ * A node of a rope: the concatenation of two strings, shared by its copies.
+ * The ropes are balanced by height, like AVL trees (the flat strings have
+ * height zero).
+ */
+struct StringNode {
+	size_t references;
+	unsigned int height;
+	String left;
+	String right;
+};
+
+/**
+ * A function that receives the contiguous pieces of a string, in order.
+ */
+typedef void (*StringVisitor)(const char * characters, const size_t length, void * context);
+
+/**
+ * The characters of a flat string (see "flattenString"). They are inline if
+ * it's short, so this must be called again after the string is moved.
+ */
+static inline const char * getCharacters(const String * string) {
+	return string->length <= SHORT_STRING_CAPACITY ? string->shortCharacters : string->buffer->characters;
+}
+
+/**
+ * Gives a string its own copy of a shared buffer. Returns NULL if the system
+ * runs out of memory, and then the string is empty.
+ */
+char * detachString(String * string);
+
+/**
+ * Turns a rope into a flat string, with contiguous characters. Returns false
+ * if the system runs out of memory, and then the string is empty.
+ */
+boolean flattenString(String * string);
+
+/**
+ * Like "getCharacters", but they can be modified, because a rope is
+ * flattened and a shared buffer is copied first (see "detachString"). Returns
+ * NULL if the system runs out of memory.
+ */
+static inline char * getMutableCharacters(String * string) {
+	if (string->length <= SHORT_STRING_CAPACITY) {
+		return string->shortCharacters;
+	}
+	if (string->rope && !flattenString(string)) {
+		return NULL;
+	}
+	return string->buffer->references == 1 ? string->buffer->characters : detachString(string);
+}
+
+/**
+ * Creates a string with a copy of some characters, which don't need to be
+ * null-terminated.
+ */
+String createString(const char * characters, const size_t length);
+
+/**
+ * Turns a string into an uninitialized one of the specified length, and
+ * returns its characters, to be filled (the null character is already
+ * there). It's not known to be ASCII. Returns NULL if the system runs out of
+ * memory, and then the string is empty.
+ */
+char * allocateString(String * string, const size_t length);
+
+/**
+ * Changes the length of a string that was allocated by "allocateString" (and
+ * not shared yet), and returns its characters. The ones that fit are kept,
+ * and the new ones are uninitialized. The buffer grows in place if possible,
+ * so it can be filled incrementally. Returns NULL if the system runs out of
+ * memory, and then the string is empty.
+ */
+char * resizeString(String * string, const size_t length);
+
+/**
+ * Creates a copy of a string, with its metadata. A long one shares the
+ * buffer (or the rope) of the original, so it's not copied until it's
+ * modified.
+ */
+String copyString(const String * string);
+
+/**
+ * Concatenates two strings, and takes the ownership of both. The short
+ * results are copied, and the long ones become a balanced rope, in
+ * logarithmic time, that shares the operands. Returns an empty string if the
+ * system runs out of memory.
+ */
+String concatenateStrings(String * left, String * right);
+
+/**
+ * Copies the characters of any string (flat or not) into a buffer, without
+ * the null character, and returns the end of the copy.
+ */
+char * copyCharacters(const String * string, char * destiny);
+
+/**
+ * Sends the contiguous pieces of any string (flat or not) to a visitor, in
+ * order, without flattening it. The empty strings have no pieces.
+ */
+void visitString(const String * string, StringVisitor visitor, void * context);
+
+/**
+ * Releases the memory of a string (if it's the last one that shares it),
+ * and it becomes empty.
+ */
+void destroyString(String * string);
+
+/**
+ * Whether every character is in the ASCII range (below 0x80).
+ */
+boolean isAscii(const char * characters, const size_t length);
+
 /**
  * Concatenates a list of strings. The returned string must be freed because
  * it uses heap-memory.
@@ -22,6 +183,12 @@ char * concatenate(const unsigned int count, ...);
  */
 char * escape(const char * string);
 
+/**
+ * Like "escape", but over the first "length" characters of the string, which
+ * doesn't need to be null-terminated (e.g., a slice of the input buffer).
+ */
+char * escapeSubstring(const char * string, const size_t length);
+
 /**
  * Generates an indentation string for the specified level, using heap-memory.
  *